@@ -0,0 +1,81 @@
+#pragma once
+#include "MazeStrategy.hpp"
+#include <atomic>
+#include <thread>
+
+// генерация лабиринта в фоновом потоке с построчной публикацией готовых строк
+//
+// строки пишутся прямо в сетку существующего лабиринта (буфер переиспользуется), после каждой
+// строки рабочий поток публикует число готовых строк (release), а читатель, получив его
+// (acquire), может читать строки [0, getReadyRows()) одновременно с генерацией остальных.
+// пока генерация идет (isRunning), лабиринт и генератор нельзя менять и нельзя читать
+// строки дальше готовых; poll() в основном потоке завершает генерацию. строки пишутся в обход
+// изменяющего доступа, поэтому poll() и cancel() по завершении меняют версию лабиринта (touch):
+// кэши, построенные по версии во время генерации, устаревают.
+class BackgroundMazeGenerator {
+private:
+    thread worker; // рабочий поток текущей генерации
+    Maze* target = nullptr; // лабиринт текущей генерации
+    atomic<int> readyRows{0}; // число полностью готовых строк
+    atomic<bool> cancelRequested{false}; // запрос отмены (проверяется после каждой строки)
+    atomic<bool> done{false}; // рабочий поток закончил (готово или отменено)
+
+public:
+    BackgroundMazeGenerator() = default;
+    ~BackgroundMazeGenerator() { cancel(); }
+
+    BackgroundMazeGenerator(const BackgroundMazeGenerator&) = delete;
+    BackgroundMazeGenerator& operator=(const BackgroundMazeGenerator&) = delete;
+
+    // запуск генерации maze генератором generator (предыдущая генерация отменяется);
+    // зерно и вид генератора записываются в лабиринт сразу, размер лабиринта не меняется
+    void start(Maze& maze, EllerMazeGenerator& generator) {
+        cancel();
+        int width = maze.getWidth(), height = maze.getHeight();
+        size_t words = maze.getWordsPerRow();
+        maze.setSeed(generator.getSeed());
+        maze.setGenerator(generator.getKind());
+        uint64_t* base = height > 0 ? maze.eastWalls(0) : nullptr; // изменяющий доступ - в этом потоке (меняет версию)
+        readyRows.store(0, memory_order_relaxed);
+        cancelRequested.store(false, memory_order_relaxed);
+        done.store(false, memory_order_relaxed);
+        target = &maze;
+        worker = thread([this, &generator, base, width, height, words] {
+            struct PublishedRows {
+                BackgroundMazeGenerator& owner;
+                uint64_t* base;
+                size_t words;
+                uint64_t* east(int y) { return base + size_t(y) * 2 * words; }
+                uint64_t* south(int y) { return east(y) + words; }
+                bool commit(int y) {
+                    owner.readyRows.store(y + 1, memory_order_release); // строка y видна читателям
+                    return !owner.cancelRequested.load(memory_order_relaxed);
+                }
+            } rows{*this, base, words};
+            generator.generateInto(width, height, words, rows);
+            done.store(true, memory_order_release);
+        });
+    }
+
+    // отмена текущей генерации с ожиданием рабочего потока (строки после готовых остаются недостроенными)
+    void cancel() {
+        if (!worker.joinable()) return;
+        cancelRequested.store(true, memory_order_relaxed);
+        worker.join();
+        target->touch(); // недостроенные строки - тоже изменение
+    }
+
+    // проверка завершения: true один раз, когда генерация закончилась и поток присоединен
+    bool poll() {
+        if (!worker.joinable() || !done.load(memory_order_acquire)) return false;
+        worker.join();
+        target->touch();
+        return !cancelRequested.load(memory_order_relaxed);
+    }
+
+    // генерация запущена и еще не завершена вызовом poll() или cancel()
+    bool isRunning() const { return worker.joinable(); }
+
+    // число готовых строк текущей генерации
+    int getReadyRows() const { return readyRows.load(memory_order_acquire); }
+};
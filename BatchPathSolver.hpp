@@ -0,0 +1,56 @@
+#pragma once
+#include "MazeStrategy.hpp"
+#include "ThreadPool.hpp"
+
+// запрос пути между двумя клетками
+struct PathQuery {
+    int startX, startY; // начальная точка
+    int endX, endY; // конечная точка
+};
+
+// результат запроса
+struct PathResult {
+    int length; // число клеток пути (0 - путь не найден)
+    size_t nodesExpanded; // сколько клеток раскрыл поиск (и при неудаче; 0 - точки вне лабиринта)
+};
+
+// пакетные запросы пути: запросы распределяются по пулу потоков с перехватом работы,
+// у каждого исполнителя свой экземпляр алгоритма (свое рабочее состояние и буфер пути),
+// результаты пишутся в заранее выделенный буфер. лабиринт во время запроса только читается.
+class BatchPathSolver {
+private:
+    WorkStealingPool pool; // исполнители
+    vector<unique_ptr<IPathFinder>> finders; // алгоритм на исполнителя
+    vector<vector<pair<int, int>>> paths; // буфер пути на исполнителя
+
+public:
+    // threads - число исполнителей (0 - по числу ядер)
+    explicit BatchPathSolver(const IPathFinder& prototype, unsigned threads = 0) : pool(threads) {
+        for (unsigned i = 0; i < pool.getThreadCount(); ++i) finders.push_back(prototype.clone());
+        paths.resize(pool.getThreadCount());
+    }
+
+    unsigned getThreadCount() const { return pool.getThreadCount(); }
+
+    // решение count запросов, results должен вмещать count результатов;
+    // chunk - сколько запросов исполнитель берет за раз
+    void solve(const Maze& maze, const PathQuery* queries, size_t count, PathResult* results, size_t chunk = 32) {
+        for (auto& finder : finders) finder->prepare(maze); // общие данные строятся до параллельной части
+        pool.parallelFor(count, chunk, [&](unsigned worker, size_t begin, size_t end) {
+            IPathFinder& finder = *finders[worker];
+            vector<pair<int, int>>& path = paths[worker];
+            for (size_t i = begin; i < end; ++i) {
+                const PathQuery& q = queries[i];
+                bool valid = maze.isValidCell(q.startX, q.startY) && maze.isValidCell(q.endX, q.endY);
+                bool found = valid && finder.findPath(maze, q.startX, q.startY, q.endX, q.endY, path);
+                results[i] = {found ? int(path.size()) : 0, valid ? finder.getNodesExpanded() : 0};
+            }
+        });
+    }
+
+    // то же для векторов: results получает размер queries
+    void solve(const Maze& maze, const vector<PathQuery>& queries, vector<PathResult>& results, size_t chunk = 32) {
+        results.resize(queries.size());
+        solve(maze, queries.data(), queries.size(), results.data(), chunk);
+    }
+};
@@ -0,0 +1,365 @@
+#pragma once
+#include "MazeStrategy.hpp"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// заливка и поиск в ширину над битовыми рядами стен: за одну операцию обрабатывается
+// слово из 64 клеток строки
+//
+// открытость проходов вправо берется прямо из рядов лабиринта (~east: бит x - проход x -> x + 1),
+// вниз - из ~south. горизонтальное замыкание слова (все клетки отрезка без стен, достижимые из
+// отмеченных) считается параллельным префиксом Когге - Стоуна за 6 сдвигов в каждую сторону,
+// переносы между словами строки - отдельным проходом. заливка ведет очередь строк, у которых
+// появились новые клетки, и для каждой строки - диапазон измененных слов. поиск в ширину
+// хранит фронт слоя битами с диапазоном слов на строку и расширяет его на шаг во все стороны.
+// при сборке с AVX2 (MAZE_ENABLE_AVX2) замыкание, вертикальный перенос и шаг слоя идут по 4 слова.
+// буферы между запросами не очищаются целиком: поиск стирает только тронутые слова, поэтому
+// короткий запрос на большом лабиринте стоит пропорционально пройденной области.
+class BitParallelBfs {
+private:
+    int width = 0, height = 0;
+    size_t words = 0; // слов на строку
+    uint64_t lastMask = 0; // клетки лабиринта в последнем слове строки
+    vector<uint64_t> reached; // достигнутые клетки (заливка) или посещенные (поиск), по строкам
+    vector<uint64_t> frontier; // фронт текущего слоя (поиск)
+    vector<uint64_t> next; // фронт следующего слоя (поиск)
+    vector<int> rows; // очередь строк (заливка) или строки фронта (поиск)
+    vector<int> nextRows; // строки следующего фронта
+    vector<int> low, high; // диапазон слов строки с новыми клетками (пусто - low > high)
+    vector<int> nextLow, nextHigh;
+    vector<int> reachedRows; // строки, в которых поиск отметил клетки
+    vector<int> reachedLow, reachedHigh; // диапазон отмеченных слов строки (пусто - low > high)
+    bool reachedAll = false; // reached после заливки: очищается целиком
+
+    // открытые проходы вправо в слове w строки (бит x - проход x -> x + 1)
+    static uint64_t openEast(const uint64_t* east, size_t w) { return ~east[w]; }
+
+    // распространение отмеченных бит g вправо по проходам p (бит x - можно пройти из x в x + 1)
+    static uint64_t spreadRight(uint64_t g, uint64_t p) {
+        g |= (g & p) << 1; p &= p >> 1;
+        g |= (g & p) << 2; p &= p >> 2;
+        g |= (g & p) << 4; p &= p >> 4;
+        g |= (g & p) << 8; p &= p >> 8;
+        g |= (g & p) << 16; p &= p >> 16;
+        return g | (g & p) << 32;
+    }
+
+    // распространение отмеченных бит g влево по тем же проходам
+    static uint64_t spreadLeft(uint64_t g, uint64_t p) {
+        g |= (g >> 1) & p; p &= p >> 1;
+        g |= (g >> 2) & p; p &= p >> 2;
+        g |= (g >> 4) & p; p &= p >> 4;
+        g |= (g >> 8) & p; p &= p >> 8;
+        g |= (g >> 16) & p; p &= p >> 16;
+        return g | ((g >> 32) & p);
+    }
+
+#ifdef __AVX2__
+    // те же распространения для 4 слов сразу (без переносов между словами)
+    static __m256i spreadRight4(__m256i g, __m256i p) {
+        g = _mm256_or_si256(g, _mm256_slli_epi64(_mm256_and_si256(g, p), 1)); p = _mm256_and_si256(p, _mm256_srli_epi64(p, 1));
+        g = _mm256_or_si256(g, _mm256_slli_epi64(_mm256_and_si256(g, p), 2)); p = _mm256_and_si256(p, _mm256_srli_epi64(p, 2));
+        g = _mm256_or_si256(g, _mm256_slli_epi64(_mm256_and_si256(g, p), 4)); p = _mm256_and_si256(p, _mm256_srli_epi64(p, 4));
+        g = _mm256_or_si256(g, _mm256_slli_epi64(_mm256_and_si256(g, p), 8)); p = _mm256_and_si256(p, _mm256_srli_epi64(p, 8));
+        g = _mm256_or_si256(g, _mm256_slli_epi64(_mm256_and_si256(g, p), 16)); p = _mm256_and_si256(p, _mm256_srli_epi64(p, 16));
+        return _mm256_or_si256(g, _mm256_slli_epi64(_mm256_and_si256(g, p), 32));
+    }
+
+    static __m256i spreadLeft4(__m256i g, __m256i p) {
+        g = _mm256_or_si256(g, _mm256_and_si256(_mm256_srli_epi64(g, 1), p)); p = _mm256_and_si256(p, _mm256_srli_epi64(p, 1));
+        g = _mm256_or_si256(g, _mm256_and_si256(_mm256_srli_epi64(g, 2), p)); p = _mm256_and_si256(p, _mm256_srli_epi64(p, 2));
+        g = _mm256_or_si256(g, _mm256_and_si256(_mm256_srli_epi64(g, 4), p)); p = _mm256_and_si256(p, _mm256_srli_epi64(p, 4));
+        g = _mm256_or_si256(g, _mm256_and_si256(_mm256_srli_epi64(g, 8), p)); p = _mm256_and_si256(p, _mm256_srli_epi64(p, 8));
+        g = _mm256_or_si256(g, _mm256_and_si256(_mm256_srli_epi64(g, 16), p)); p = _mm256_and_si256(p, _mm256_srli_epi64(p, 16));
+        return _mm256_or_si256(g, _mm256_and_si256(_mm256_srli_epi64(g, 32), p));
+    }
+#endif
+
+    // подготовка буферов под лабиринт: при том же размере стираются только слова, отмеченные
+    // прошлым поиском (фронты и диапазоны строк после поиска и заливки уже пусты)
+    void prepare(const Maze& maze) {
+        if (maze.getWidth() != width || maze.getHeight() != height || reached.size() != words * size_t(max(height, 0))) {
+            width = maze.getWidth();
+            height = maze.getHeight();
+            words = maze.getWordsPerRow();
+            lastMask = (width & 63) ? (uint64_t(1) << (width & 63)) - 1 : ~uint64_t(0);
+            size_t total = words * size_t(max(height, 0));
+            size_t rowCount = size_t(max(height, 0));
+            reached.assign(total, 0);
+            frontier.assign(total, 0);
+            next.assign(total, 0);
+            low.assign(rowCount, INT_MAX);
+            high.assign(rowCount, -1);
+            nextLow.assign(rowCount, INT_MAX);
+            nextHigh.assign(rowCount, -1);
+            reachedLow.assign(rowCount, INT_MAX);
+            reachedHigh.assign(rowCount, -1);
+            reachedRows.clear();
+            reachedAll = false;
+        } else if (reachedAll) {
+            reached.assign(reached.size(), 0);
+            reachedAll = false;
+        } else {
+            for (int y : reachedRows) {
+                uint64_t* row = &reached[size_t(y) * words];
+                for (int w = reachedLow[y]; w <= reachedHigh[y]; ++w) row[w] = 0;
+                reachedLow[y] = INT_MAX;
+                reachedHigh[y] = -1;
+            }
+        }
+        reachedRows.clear();
+        rows.clear();
+        nextRows.clear();
+    }
+
+    // учет посещенных поиском слов [from, to] строки y (для частичной очистки)
+    void markReached(int y, int from, int to) {
+        if (reachedLow[y] > reachedHigh[y]) reachedRows.push_back(y);
+        reachedLow[y] = min(reachedLow[y], from);
+        reachedHigh[y] = max(reachedHigh[y], to);
+    }
+
+    // горизонтальное замыкание строки row (открытые проходы east) по словам [from, to],
+    // переносы продолжаются за границы диапазона; возвращает диапазон измененных слов
+    pair<int, int> closeRow(uint64_t* row, const uint64_t* east, int from, int to) const {
+        int last = int(words) - 1;
+        int changedLow = from, changedHigh = to;
+#ifdef __AVX2__
+        int w = from;
+        for (; w + 3 <= to; w += 4) { // замыкание внутри слов, по 4 слова
+            __m256i g = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + w));
+            __m256i p = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(east + w)), _mm256_set1_epi64x(-1));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + w), spreadLeft4(spreadRight4(g, p), p));
+        }
+        for (; w <= to; ++w) {
+            uint64_t p = openEast(east, size_t(w));
+            row[w] = spreadLeft(spreadRight(row[w], p), p);
+        }
+#else
+        for (int w = from; w <= to; ++w) {
+            uint64_t p = openEast(east, size_t(w));
+            row[w] = spreadLeft(spreadRight(row[w], p), p);
+        }
+#endif
+        // переносы вправо: клетка 63 слова w - 1 с проходом вправо открывает клетку 0 слова w
+        for (int w = max(from, 1); w <= last; ++w) {
+            bool carry = (row[w - 1] >> 63) & (openEast(east, size_t(w - 1)) >> 63);
+            if (!carry || (row[w] & 1)) {
+                if (w > to) break; // за диапазоном изменения возможны только через перенос
+                continue;
+            }
+            uint64_t p = openEast(east, size_t(w));
+            row[w] = spreadLeft(spreadRight(row[w] | 1, p), p);
+            changedHigh = max(changedHigh, w);
+        }
+        // переносы влево: клетка 0 слова w + 1 открывает клетку 63 слова w, если проход открыт
+        for (int w = min(changedHigh, last) - 1; w >= 0; --w) {
+            bool carry = (row[w + 1] & 1) & (openEast(east, size_t(w)) >> 63);
+            if (!carry || (row[w] >> 63)) {
+                if (w < from) break;
+                continue;
+            }
+            uint64_t p = openEast(east, size_t(w));
+            row[w] = spreadRight(spreadLeft(row[w] | (uint64_t(1) << 63), p), p);
+            changedLow = min(changedLow, w);
+        }
+        row[last] &= lastMask;
+        return {changedLow, changedHigh};
+    }
+
+    // перенос клеток строки source по открытым проходам south в строку target (слова [from, to]);
+    // возвращает true, если в target появились новые клетки
+    static bool spreadVertical(const uint64_t* source, const uint64_t* south, uint64_t* target, int from, int to) {
+        uint64_t added = 0;
+        int w = from;
+#ifdef __AVX2__
+        __m256i any = _mm256_setzero_si256();
+        for (; w + 3 <= to; w += 4) {
+            __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + w));
+            __m256i wall = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(south + w));
+            __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + w));
+            __m256i add = _mm256_andnot_si256(t, _mm256_andnot_si256(wall, s)); // s & ~wall & ~t
+            any = _mm256_or_si256(any, add);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(target + w), _mm256_or_si256(t, add));
+        }
+        added = _mm256_testz_si256(any, any) ? 0 : 1;
+#endif
+        for (; w <= to; ++w) {
+            uint64_t add = source[w] & ~south[w] & ~target[w];
+            target[w] |= add;
+            added |= add;
+        }
+        return added != 0;
+    }
+
+    // добавление строки y в очередь заливки с диапазоном слов [from, to]
+    void touchRow(int y, int from, int to) {
+        if (low[y] > high[y]) rows.push_back(y); // строка не в очереди
+        low[y] = min(low[y], from);
+        high[y] = max(high[y], to);
+    }
+
+    // поиск в ширину от (startX, startY) до клетки target (-1 - до исчерпания), возвращает
+    // номер слоя, в котором найдена цель, или число слоев при target == -1 (-1 - цель недостижима)
+    int runLayers(const Maze& maze, int startX, int startY, int target) {
+        prepare(maze);
+        if (!maze.isValidCell(startX, startY)) return -1;
+
+        int targetY = target < 0 ? -1 : target / width;
+        int targetWord = target < 0 ? 0 : (target % width) >> 6;
+        uint64_t targetBit = target < 0 ? 0 : uint64_t(1) << (target % width & 63);
+        size_t start = size_t(startY) * words + size_t(startX >> 6);
+        frontier[start] = reached[start] = uint64_t(1) << (startX & 63);
+        rows.push_back(startY);
+        low[startY] = high[startY] = startX >> 6;
+        int last = int(words) - 1;
+
+        // добавление бит add в слово w строки y следующего фронта (кроме посещенных)
+        auto addNext = [&](int y, int w, uint64_t add) {
+            size_t index = size_t(y) * words + size_t(w);
+            add &= ~reached[index];
+            if (!add) return;
+            reached[index] |= add;
+            next[index] |= add;
+            if (nextLow[y] > nextHigh[y]) nextRows.push_back(y);
+            nextLow[y] = min(nextLow[y], w);
+            nextHigh[y] = max(nextHigh[y], w);
+        };
+#ifdef __AVX2__
+        // то же для слов [w, w + 3] строки y
+        auto addNext4 = [&](int y, int w, __m256i add) {
+            size_t index = size_t(y) * words + size_t(w);
+            __m256i seen = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&reached[index]));
+            add = _mm256_andnot_si256(seen, add);
+            if (_mm256_testz_si256(add, add)) return;
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&reached[index]), _mm256_or_si256(seen, add));
+            __m256i pending = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&next[index]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&next[index]), _mm256_or_si256(pending, add));
+            if (nextLow[y] > nextHigh[y]) nextRows.push_back(y);
+            nextLow[y] = min(nextLow[y], w);
+            nextHigh[y] = max(nextHigh[y], w + 3);
+        };
+#endif
+        // переход через границу слова w строки y: клетка 0 - в клетку 63 слова слева, клетка 63 - вправо
+        auto addCarries = [&](int y, const uint64_t* east, int w, uint64_t bits) {
+            if (w > 0 && (bits & 1) && (openEast(east, size_t(w - 1)) >> 63)) addNext(y, w - 1, uint64_t(1) << 63);
+            if (w < last && (bits >> 63) && (openEast(east, size_t(w)) >> 63)) addNext(y, w + 1, 1);
+        };
+
+        for (int layer = 0; !rows.empty(); ++layer) {
+            if (targetY >= 0 && (frontier[size_t(targetY) * words + size_t(targetWord)] & targetBit)) {
+                for (int y : rows) { // цель найдена: стираем нераскрытый фронт
+                    markReached(y, low[y], high[y]);
+                    for (int w = low[y]; w <= high[y]; ++w) frontier[size_t(y) * words + size_t(w)] = 0;
+                    low[y] = INT_MAX;
+                    high[y] = -1;
+                }
+                return layer;
+            }
+            for (int y : rows) {
+                uint64_t* row = &frontier[size_t(y) * words];
+                const uint64_t* east = maze.eastWalls(y);
+                const uint64_t* south = maze.southWalls(y);
+                const uint64_t* northSouth = y > 0 ? maze.southWalls(y - 1) : nullptr;
+                markReached(y, low[y], high[y]); // посещенные слова - ровно слова прошедших фронтов
+                // шаг слоя для одного слова фронта
+                auto expandWord = [&](int w) {
+                    uint64_t bits = row[w];
+                    uint64_t p = openEast(east, size_t(w));
+                    uint64_t horizontal = ((bits & p) << 1) | ((bits >> 1) & p); // шаг вправо и влево внутри слова
+                    addNext(y, w, horizontal & (w == last ? lastMask : ~uint64_t(0)));
+                    addCarries(y, east, w, bits);
+                    if (y + 1 < height) addNext(y + 1, w, bits & ~south[w]); // вниз
+                    if (northSouth) addNext(y - 1, w, bits & ~northSouth[w]); // вверх
+                    row[w] = 0; // слой раскрыт
+                };
+                int w = low[y];
+#ifdef __AVX2__
+                for (; w + 3 <= high[y]; w += 4) { // по 4 слова: шаги внутри слов и по вертикали
+                    __m256i bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + w));
+                    int empty = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(bits, _mm256_setzero_si256())));
+                    if (empty == 15) continue;
+                    if (popCount64(uint64_t(empty)) >= 3) { // фронт лабиринта редкий: одно слово дешевле скалярно
+                        expandWord(w + lowestBit64(uint64_t(~empty & 15)));
+                        continue;
+                    }
+                    __m256i p = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(east + w)), _mm256_set1_epi64x(-1));
+                    __m256i horizontal = _mm256_or_si256(_mm256_slli_epi64(_mm256_and_si256(bits, p), 1),
+                        _mm256_and_si256(_mm256_srli_epi64(bits, 1), p));
+                    if (w + 3 == last) horizontal = _mm256_and_si256(horizontal, _mm256_set_epi64x(int64_t(lastMask), -1, -1, -1));
+                    addNext4(y, w, horizontal);
+                    if (y + 1 < height) { // вниз
+                        addNext4(y + 1, w, _mm256_andnot_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(south + w)), bits));
+                    }
+                    if (northSouth) { // вверх
+                        addNext4(y - 1, w, _mm256_andnot_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(northSouth + w)), bits));
+                    }
+                    for (int k = w; k < w + 4; ++k) addCarries(y, east, k, row[k]);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + w), _mm256_setzero_si256()); // слой раскрыт
+                }
+#endif
+                for (; w <= high[y]; ++w) {
+                    if (row[w]) expandWord(w);
+                }
+                low[y] = INT_MAX;
+                high[y] = -1;
+            }
+            // следующий фронт становится текущим
+            rows.swap(nextRows);
+            nextRows.clear();
+            frontier.swap(next);
+            low.swap(nextLow);
+            high.swap(nextHigh);
+            if (rows.empty()) return target < 0 ? layer + 1 : -1;
+        }
+        return -1;
+    }
+
+public:
+    // заливка от (startX, startY): возвращает число достижимых клеток, сами клетки - isReached
+    size_t fill(const Maze& maze, int startX, int startY) {
+        prepare(maze);
+        reachedAll = true; // заливка отмечает слова без учета диапазонов
+        if (!maze.isValidCell(startX, startY)) return 0;
+        reached[size_t(startY) * words + size_t(startX >> 6)] = uint64_t(1) << (startX & 63);
+        touchRow(startY, startX >> 6, startX >> 6);
+        while (!rows.empty()) {
+            int y = rows.back(); // обработка в порядке стека: свежие строки еще в кэше
+            rows.pop_back();
+            int from = low[y], to = high[y];
+            low[y] = INT_MAX;
+            high[y] = -1;
+            uint64_t* row = &reached[size_t(y) * words];
+            pair<int, int> changed = closeRow(row, maze.eastWalls(y), from, to);
+            if (y + 1 < height && spreadVertical(row, maze.southWalls(y), row + words, changed.first, changed.second)) {
+                touchRow(y + 1, changed.first, changed.second);
+            }
+            if (y > 0 && spreadVertical(row, maze.southWalls(y - 1), row - words, changed.first, changed.second)) {
+                touchRow(y - 1, changed.first, changed.second);
+            }
+        }
+        size_t count = 0;
+        for (uint64_t word : reached) count += size_t(popCount64(word));
+        return count;
+    }
+
+    // клетка достигнута последней заливкой (или посещена последним поиском)
+    bool isReached(int x, int y) const {
+        return (reached[size_t(y) * words + size_t(x >> 6)] >> (x & 63)) & 1;
+    }
+
+    // биты достигнутых клеток строки y
+    const uint64_t* reachedRow(int y) const { return &reached[size_t(y) * words]; }
+
+    // длина кратчайшего пути (в шагах) между клетками, -1 - недостижима
+    int distance(const Maze& maze, int startX, int startY, int endX, int endY) {
+        if (!maze.isValidCell(endX, endY)) return -1;
+        return runLayers(maze, startX, startY, endY * maze.getWidth() + endX);
+    }
+
+    // число слоев поиска в ширину от клетки (эксцентриситет + 1)
+    int layerCount(const Maze& maze, int startX, int startY) {
+        return runLayers(maze, startX, startY, -1);
+    }
+};
@@ -0,0 +1,368 @@
+#pragma once
+#include "BatchPathSolver.hpp"
+#include "ParallelMazeGenerator.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+// пакетные задания без окна: генерация лабиринта и поиск путей по описаниям из текстового потока
+//
+// задание - строка вида
+//     ширина высота зерно генератор алгоритм [sx sy ex ey]... [random N]
+// генератор - eller, counter (Эллер в счетном режиме) или parallel[:N] (по блокам, N потоков
+// генерации, по умолчанию 1: от N зависит разбиение на блоки), алгоритм - имя
+// из pathFinderNames() или none (только генерация); random N добавляет N случайных запросов,
+// зависящих только от зерна. пустые строки и строки с # пропускаются. задание с ошибкой
+// (неверная строка, лабиринт больше BatchJob::MAX_CELLS, больше BatchJob::MAX_QUERIES запросов,
+// запрос за пределами лабиринта, сбой генерации или сохранения) дает запись об ошибке,
+// остальные задания выполняются.
+//
+// обработка идет конвейером: основной поток читает окно заданий, пул исполнителей генерирует
+// и решает их (у исполнителя свои экземпляры алгоритмов), поток вывода тем временем пишет
+// предыдущее окно. результаты выводятся в порядке заданий, а при одинаковом входе (без
+// замеров времени) выход побайтно одинаков при любом числе потоков.
+struct BatchJob {
+    static constexpr uint64_t MAX_CELLS = uint64_t(1) << 28; // клеток в лабиринте (стены - 64 МБ)
+    static constexpr size_t MAX_QUERIES = size_t(1) << 20; // запросов в задании
+
+    size_t index = 0; // номер задания
+    int width = 0, height = 0;
+    uint64_t seed = 0;
+    string generator; // eller, counter, parallel или parallel:N
+    unsigned generatorThreads = 1; // потоков генерации для parallel
+    string finder; // имя алгоритма или none
+    vector<PathQuery> queries;
+    string error; // ошибка разбора (задание не выполняется)
+};
+
+// запись задания в двоичном выводе, за ней queryCount записей BatchQueryRecord
+struct BatchJobRecord {
+    static constexpr uint32_t MAGIC = 0x424F4A4D; // "MJOB"
+
+    uint32_t magic = MAGIC;
+    uint32_t status = 0; // 0 - выполнено, 1 - ошибка задания
+    uint64_t index = 0; // номер задания
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint64_t seed = 0;
+    uint32_t queryCount = 0;
+    uint32_t reserved = 0;
+    uint64_t generateUs = 0; // время генерации (0 без замеров)
+    uint64_t solveUs = 0; // время поиска (0 без замеров)
+};
+static_assert(sizeof(BatchJobRecord) == 56, "batch job record must be 56 bytes");
+
+// запись запроса в двоичном выводе
+struct BatchQueryRecord {
+    int32_t startX, startY, endX, endY;
+    int32_t length; // число клеток пути (0 - путь не найден)
+    uint32_t nodesExpanded;
+};
+static_assert(sizeof(BatchQueryRecord) == 24, "batch query record must be 24 bytes");
+
+// разбор строки задания (ошибка записывается в job.error)
+inline void parseBatchJob(const string& line, BatchJob& job) {
+    istringstream in(line);
+    if (!(in >> job.width >> job.height >> job.seed >> job.generator >> job.finder)) {
+        job.error = "expected: width height seed generator finder [queries]";
+        return;
+    }
+    if (job.width <= 0 || job.height <= 0) {
+        job.error = "maze size must be positive";
+        return;
+    }
+    if (uint64_t(job.width) * uint64_t(job.height) > BatchJob::MAX_CELLS) {
+        job.error = "maze too large: at most " + to_string(BatchJob::MAX_CELLS) + " cells";
+        return;
+    }
+    if (job.generator.compare(0, 9, "parallel:") == 0) {
+        istringstream threads(job.generator.substr(9));
+        if (!(threads >> job.generatorThreads) || !threads.eof() || job.generatorThreads == 0 ||
+            job.generatorThreads > 256) {
+            job.error = "bad generator thread count: " + job.generator;
+            return;
+        }
+    } else if (job.generator != "eller" && job.generator != "counter" && job.generator != "parallel") {
+        job.error = "unknown generator: " + job.generator;
+        return;
+    }
+    const auto& names = pathFinderNames();
+    if (job.finder != "none" && find(names.begin(), names.end(), job.finder) == names.end()) {
+        job.error = "unknown finder: " + job.finder;
+        return;
+    }
+    string token;
+    while (in >> token) {
+        if (token == "random") { // случайные запросы от зерна задания
+            long long count = -1;
+            if (!(in >> count) || count < 0) {
+                job.error = "random expects a query count";
+                return;
+            }
+            if (uint64_t(count) > BatchJob::MAX_QUERIES - job.queries.size()) {
+                job.error = "too many queries: at most " + to_string(BatchJob::MAX_QUERIES);
+                return;
+            }
+            mt19937_64 rng(mixBits64(job.seed ^ 0x5155455259ull)); // не совпадает с потоком генератора
+            for (long long i = 0; i < count; ++i) {
+                PathQuery q;
+                q.startX = int(rng() % uint64_t(job.width));
+                q.startY = int(rng() % uint64_t(job.height));
+                q.endX = int(rng() % uint64_t(job.width));
+                q.endY = int(rng() % uint64_t(job.height));
+                job.queries.push_back(q);
+            }
+            continue;
+        }
+        PathQuery q;
+        istringstream first(token);
+        if (!(first >> q.startX) || !first.eof() || !(in >> q.startY >> q.endX >> q.endY)) {
+            job.error = "bad query near '" + token + "'";
+            return;
+        }
+        if (job.queries.size() == BatchJob::MAX_QUERIES) {
+            job.error = "too many queries: at most " + to_string(BatchJob::MAX_QUERIES);
+            return;
+        }
+        if (q.startX < 0 || q.startX >= job.width || q.startY < 0 || q.startY >= job.height ||
+            q.endX < 0 || q.endX >= job.width || q.endY < 0 || q.endY >= job.height) {
+            job.error = "query outside the maze: " + to_string(q.startX) + " " + to_string(q.startY) + " " +
+                to_string(q.endX) + " " + to_string(q.endY);
+            return;
+        }
+        job.queries.push_back(q);
+    }
+}
+
+// выполнение заданий пакетами
+class MazeBatchRunner {
+public:
+    struct Options {
+        unsigned threads = 0; // исполнителей (0 - по числу ядер)
+        bool binary = false; // двоичный вывод (BatchJobRecord/BatchQueryRecord) вместо текста
+        bool timing = false; // замеры времени в выводе (выход перестает быть воспроизводимым)
+        string mazeDirectory; // каталог для лабиринтов job-N.maze (пусто - не сохранять)
+        size_t window = 0; // заданий в окне конвейера (0 - 4 на исполнителя)
+    };
+
+    // итоги выполнения
+    struct Summary {
+        size_t jobs = 0;
+        size_t failed = 0; // задания с ошибкой
+        size_t queries = 0;
+        uint64_t cells = 0; // сгенерировано клеток
+    };
+
+private:
+    // лабиринты больше этого после задания не держат рабочие состояния алгоритмов исполнителя
+    static constexpr uint64_t RETAIN_CELLS = uint64_t(1) << 22;
+
+    // состояние исполнителя: экземпляры алгоритмов по именам и буфер пути
+    struct Worker {
+        unordered_map<string, unique_ptr<IPathFinder>> finders;
+        vector<pair<int, int>> path;
+    };
+
+    // поток вывода: пишет готовые окна по порядку, пока основной поток считает следующее
+    class OrderedWriter {
+    private:
+        ostream& out;
+        mutex lock;
+        condition_variable changed;
+        vector<string> pending; // окно, ожидающее записи
+        bool hasPending = false;
+        bool closing = false;
+        thread worker;
+
+        void writeLoop() {
+            for (;;) {
+                vector<string> chunk;
+                {
+                    unique_lock<mutex> guard(lock);
+                    changed.wait(guard, [&] { return hasPending || closing; });
+                    if (!hasPending) return;
+                    chunk.swap(pending);
+                    hasPending = false;
+                }
+                changed.notify_all(); // место для следующего окна освободилось
+                for (const string& text : chunk) out.write(text.data(), streamsize(text.size()));
+                out.flush(); // результаты окна видны сразу (потоковый вывод)
+            }
+        }
+
+    public:
+        explicit OrderedWriter(ostream& out) : out(out), worker(&OrderedWriter::writeLoop, this) {}
+
+        ~OrderedWriter() {
+            {
+                lock_guard<mutex> guard(lock);
+                closing = true;
+            }
+            changed.notify_all();
+            worker.join(); // ожидающее окно дописывается до выхода
+        }
+
+        // передача окна на запись (ждет, пока предыдущее окно будет взято потоком вывода)
+        void submit(vector<string>&& chunk) {
+            unique_lock<mutex> guard(lock);
+            changed.wait(guard, [&] { return !hasPending; });
+            pending = move(chunk);
+            hasPending = true;
+            changed.notify_all();
+        }
+    };
+
+    Options options;
+    WorkStealingPool pool;
+    vector<Worker> workers;
+
+    static uint64_t microsecondsSince(chrono::steady_clock::time_point start) {
+        return uint64_t(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+    }
+
+    static void appendBytes(string& out, const void* data, size_t size) {
+        out.append(static_cast<const char*>(data), size);
+    }
+
+    // запись задания с ошибкой
+    string formatError(const BatchJob& job) const {
+        if (!options.binary) return "error " + to_string(job.index) + " " + job.error + "\n";
+        BatchJobRecord record;
+        record.status = 1;
+        record.index = job.index;
+        string out;
+        appendBytes(out, &record, sizeof(record));
+        return out;
+    }
+
+    // выполнение одного задания исполнителем worker, результат - готовый фрагмент вывода
+    string runJob(const BatchJob& job, Worker& worker) {
+        if (!job.error.empty()) return formatError(job);
+
+        auto start = chrono::steady_clock::now();
+        Maze maze(job.width, job.height);
+        if (job.generator.compare(0, 8, "parallel") == 0) {
+            // блоки - в этом исполнителе: вложенный пул на задание дал бы до T x N потоков
+            ParallelBlockMazeGenerator(job.generatorThreads, job.seed,
+                ParallelBlockMazeGenerator::Execution::CallerThread).generate(maze);
+        } else {
+            EllerMazeGenerator generator(job.seed, job.generator == "counter"
+                ? EllerMazeGenerator::RandomMode::Counter : EllerMazeGenerator::RandomMode::Sequential);
+            generator.generate(maze);
+        }
+        uint64_t generateUs = microsecondsSince(start);
+        if (!options.mazeDirectory.empty()) {
+            maze.save(options.mazeDirectory + "/job-" + to_string(job.index) + ".maze");
+        }
+
+        start = chrono::steady_clock::now();
+        vector<PathResult> results(job.queries.size(), PathResult{0, 0});
+        if (job.finder != "none" && !job.queries.empty()) {
+            unique_ptr<IPathFinder>& finder = worker.finders[job.finder];
+            if (!finder) finder = makePathFinder(job.finder);
+            finder->prepare(maze);
+            for (size_t i = 0; i < job.queries.size(); ++i) { // координаты проверены при разборе
+                const PathQuery& q = job.queries[i];
+                bool found = finder->findPath(maze, q.startX, q.startY, q.endX, q.endY, worker.path);
+                results[i] = {found ? int(worker.path.size()) : 0, finder->getNodesExpanded()};
+            }
+            if (uint64_t(job.width) * uint64_t(job.height) > RETAIN_CELLS) { // память под большой лабиринт не держим
+                worker.finders.erase(job.finder);
+                vector<pair<int, int>>().swap(worker.path);
+            }
+        }
+        uint64_t solveUs = microsecondsSince(start);
+        if (!options.timing) generateUs = solveUs = 0;
+
+        string out;
+        if (options.binary) {
+            BatchJobRecord record;
+            record.index = job.index;
+            record.width = uint32_t(job.width);
+            record.height = uint32_t(job.height);
+            record.seed = job.seed;
+            record.queryCount = uint32_t(job.queries.size());
+            record.generateUs = generateUs;
+            record.solveUs = solveUs;
+            appendBytes(out, &record, sizeof(record));
+            for (size_t i = 0; i < job.queries.size(); ++i) {
+                const PathQuery& q = job.queries[i];
+                BatchQueryRecord query{q.startX, q.startY, q.endX, q.endY, results[i].length,
+                    uint32_t(min<size_t>(results[i].nodesExpanded, UINT32_MAX))};
+                appendBytes(out, &query, sizeof(query));
+            }
+            return out;
+        }
+
+        // текст: строка задания, затем строка на запрос
+        out = "job " + to_string(job.index) + " " + to_string(job.width) + " " + to_string(job.height) + " " +
+            to_string(job.seed) + " " + job.generator + " " + job.finder + " " + to_string(job.queries.size());
+        if (options.timing) out += " " + to_string(generateUs) + "us " + to_string(solveUs) + "us";
+        out += "\n";
+        for (size_t i = 0; i < job.queries.size(); ++i) {
+            const PathQuery& q = job.queries[i];
+            out += "path " + to_string(q.startX) + " " + to_string(q.startY) + " " + to_string(q.endX) + " " +
+                to_string(q.endY) + " " + to_string(results[i].length) + " " + to_string(results[i].nodesExpanded) + "\n";
+        }
+        return out;
+    }
+
+public:
+    explicit MazeBatchRunner(const Options& options)
+        : options(options), pool(options.threads), workers(pool.getThreadCount()) {
+        if (this->options.window == 0) this->options.window = size_t(pool.getThreadCount()) * 4;
+    }
+
+    unsigned getThreadCount() const { return pool.getThreadCount(); }
+
+    // выполнение всех заданий из in с выводом результатов в out
+    Summary run(istream& in, ostream& out) {
+        Summary summary;
+        OrderedWriter writer(out);
+        string line;
+        bool more = true;
+        while (more) {
+            // чтение окна заданий
+            vector<BatchJob> jobs;
+            while (jobs.size() < options.window && (more = bool(getline(in, line)))) {
+                size_t first = line.find_first_not_of(" \t\r");
+                if (first == string::npos || line[first] == '#') continue;
+                jobs.emplace_back();
+                jobs.back().index = summary.jobs++;
+                try {
+                    parseBatchJob(line, jobs.back());
+                } catch (const exception& error) { // например, нехватка памяти под запросы
+                    jobs.back().queries = vector<PathQuery>();
+                    jobs.back().error = error.what();
+                }
+            }
+            if (jobs.empty()) break;
+
+            // генерация и поиск на пуле, фрагменты вывода - по местам заданий
+            vector<string> chunk(jobs.size());
+            pool.parallelFor(jobs.size(), 1, [&](unsigned worker, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    try {
+                        chunk[i] = runJob(jobs[i], workers[worker]);
+                    } catch (const exception& error) { // например, не удалось сохранить лабиринт
+                        workers[worker].finders.clear(); // состояния могли остаться недостроенными
+                        jobs[i].error = error.what();
+                        chunk[i] = formatError(jobs[i]);
+                    }
+                }
+            });
+            for (const BatchJob& job : jobs) {
+                if (!job.error.empty()) {
+                    ++summary.failed;
+                    continue;
+                }
+                summary.queries += job.queries.size();
+                summary.cells += uint64_t(job.width) * job.height;
+            }
+            writer.submit(move(chunk)); // пишется, пока считается следующее окно
+        }
+        return summary;
+    }
+};
@@ -0,0 +1,572 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "MazeStrategy.hpp"
+#include <cmath>
+#include <cstdio>
+#include <unordered_map>
+
+// отрисовка лабиринта средствами SFML (ядро в MazeStrategy.hpp от SFML не зависит)
+
+// добавление прямоугольника (два треугольника) в массив вершин
+inline void appendRect(sf::VertexArray& vertices, float x, float y, float w, float h, sf::Color color) {
+    vertices.append(sf::Vertex(sf::Vector2f(x, y), color));
+    vertices.append(sf::Vertex(sf::Vector2f(x + w, y), color));
+    vertices.append(sf::Vertex(sf::Vector2f(x + w, y + h), color));
+    vertices.append(sf::Vertex(sf::Vector2f(x, y), color));
+    vertices.append(sf::Vertex(sf::Vector2f(x + w, y + h), color));
+    vertices.append(sf::Vertex(sf::Vector2f(x, y + h), color));
+}
+
+// отрисовщик лабиринта с отсечением по области видимости
+//
+// при крупном масштабе (от DETAIL_PIXELS пикселей на клетку) стены видимой области
+// собираются в один sf::VertexArray с запасом вокруг экрана и пересобираются, только когда
+// вид выходит за запас или лабиринт меняется. при мелком масштабе лабиринт делится на тайлы,
+// заранее отрисованные в sf::RenderTexture: уровень детализации L покрывает тайлом
+// TILE_CELLS << L клеток, уровни 0..2 рисуют стены, начиная с 3 каждый тексель усредняет
+// блок клеток (яркость - доля стен). тайлы кэшируются (LRU), рисуются только видимые.
+class MazeRenderer {
+private:
+    static constexpr int TILE_CELLS = 64; // клеток в стороне тайла уровня 0
+    static constexpr int TILE_PIXELS = 512; // размер текстуры тайла (8 текселей на клетку на уровне 0)
+    static constexpr int DETAIL_PIXELS = 8; // от этого масштаба стены рисуются напрямую
+    static constexpr size_t MAX_TILES = 128; // размер кэша тайлов
+    static constexpr int MAX_BUILDS_PER_FRAME = 6; // новых тайлов за кадр (остальные - в следующих кадрах)
+
+    struct Tile {
+        unique_ptr<sf::RenderTexture> texture; // отрисованный тайл
+        uint64_t lastUsed = 0; // кадр последнего использования (для LRU)
+        int rows = 0; // до какой строки лабиринта тайл отрисован (при построчной генерации)
+    };
+
+    unordered_map<uint64_t, Tile> tiles; // кэш тайлов по ключу (уровень, тайл x, тайл y)
+    vector<unique_ptr<sf::RenderTexture>> freeTextures; // текстуры вытесненных тайлов для повторного использования
+    const Maze* builtMaze = nullptr; // для какого лабиринта построены кэши
+    uint64_t builtRevision = 0; // и какой его версии
+    float builtCellSize = 0; // и какого размера клетки
+    uint64_t frame = 0; // номер кадра
+    bool pending = false; // в последнем кадре не все видимые тайлы построены или обновлены
+
+    sf::VertexArray detail; // стены видимой области при крупном масштабе
+    sf::IntRect detailCells; // область клеток, для которой собран detail
+    int detailRows = 0; // до какой строки лабиринта собран detail
+    bool detailValid = false;
+
+    sf::VertexArray scratch; // временная геометрия для отрисовки тайла
+    sf::Image scratchImage; // усредненный тайл
+    sf::Texture scratchTexture;
+
+    static uint64_t tileKey(int level, int tx, int ty) {
+        return (uint64_t(level) << 58) | (uint64_t(ty) << 29) | uint64_t(tx);
+    }
+
+    // число единичных бит ряда в диапазоне [from, to)
+    static int countBits(const uint64_t* row, int from, int to) {
+        int count = 0;
+        while (from < to) {
+            int bit = from & 63;
+            int take = min(64 - bit, to - from);
+            uint64_t mask = take == 64 ? ~uint64_t(0) : ((uint64_t(1) << take) - 1) << bit;
+            count += popCount64(row[from >> 6] & mask);
+            from += take;
+        }
+        return count;
+    }
+
+    // стены клеток [x0, x1) x [y0, y1), клетка размером cell, стена толщиной wall
+    static void appendWalls(sf::VertexArray& out, const Maze& maze, int x0, int y0, int x1, int y1,
+        float originX, float originY, float cell, float wall) {
+        for (int y = y0; y < y1; ++y) {
+            const uint64_t* east = maze.eastWalls(y);
+            const uint64_t* south = maze.southWalls(y);
+            float py = originY + (y - y0) * cell;
+            if (y == 0) appendRect(out, originX, originY, (x1 - x0) * cell, wall, sf::Color::White); // верхняя граница
+            if (x0 == 0) appendRect(out, originX, py, wall, cell, sf::Color::White); // левая граница
+            for (int x = x0; x < x1; ) {
+                // перебираем единичные биты слова, ограниченного диапазоном [x, x1)
+                int take = min(64 - (x & 63), x1 - x);
+                uint64_t mask = take == 64 ? ~uint64_t(0) : ((uint64_t(1) << take) - 1) << (x & 63);
+                int base = x & ~63;
+                for (uint64_t bits = east[x >> 6] & mask; bits; bits &= bits - 1) { // правые стены
+                    int cx = base + lowestBit64(bits);
+                    appendRect(out, originX + (cx - x0 + 1) * cell - wall, py, wall, cell, sf::Color::White);
+                }
+                for (uint64_t bits = south[x >> 6] & mask; bits; bits &= bits - 1) { // нижние стены
+                    int cx = base + lowestBit64(bits);
+                    appendRect(out, originX + (cx - x0) * cell, py + cell - wall, cell, wall, sf::Color::White);
+                }
+                x += take;
+            }
+        }
+    }
+
+    // отрисовка тайла (level, tx, ty) в текстуру, только строки до rowLimit; возвращает границу отрисованных строк
+    int renderTile(sf::RenderTexture& texture, const Maze& maze, int level, int tx, int ty, int rowLimit) {
+        int span = TILE_CELLS << level; // клеток в стороне тайла
+        int x0 = tx * span, y0 = ty * span;
+        int x1 = min(maze.getWidth(), x0 + span), y1 = min({maze.getHeight(), y0 + span, rowLimit});
+        texture.clear(sf::Color::Transparent);
+
+        if (level < 3) { // стены рисуются геометрией
+            float cell = float(TILE_PIXELS >> 6 >> level); // текселей на клетку: 8, 4, 2
+            scratch.clear();
+            scratch.setPrimitiveType(sf::Triangles);
+            appendWalls(scratch, maze, x0, y0, x1, y1, 0, 0, cell, max(1.0f, cell / 4));
+            texture.draw(scratch);
+        } else { // тексель усредняет блок block x block клеток
+            int block = 1 << (level - 3);
+            scratchImage.create(TILE_PIXELS, TILE_PIXELS, sf::Color::Transparent);
+            for (int j = 0; j * block + y0 < y1; ++j) {
+                for (int i = 0; i * block + x0 < x1; ++i) {
+                    int bx0 = x0 + i * block, bx1 = min(x1, bx0 + block);
+                    int by0 = y0 + j * block, by1 = min(y1, by0 + block);
+                    int walls = 0;
+                    for (int y = by0; y < by1; ++y) {
+                        walls += countBits(maze.eastWalls(y), bx0, bx1) + countBits(maze.southWalls(y), bx0, bx1);
+                    }
+                    int cells = (bx1 - bx0) * (by1 - by0);
+                    auto shade = sf::Uint8(int64_t(255) * walls / (2 * int64_t(cells))); // доля стен в блоке
+                    scratchImage.setPixel(i, j, sf::Color(shade, shade, shade));
+                }
+            }
+            scratchTexture.loadFromImage(scratchImage);
+            texture.draw(sf::Sprite(scratchTexture));
+        }
+        texture.display();
+        return y1;
+    }
+
+    // сброс кэшей при смене лабиринта
+    void invalidate(const Maze& maze, float cellSize) {
+        for (auto& entry : tiles) freeTextures.push_back(move(entry.second.texture));
+        tiles.clear();
+        detailValid = false;
+        builtMaze = &maze;
+        builtRevision = maze.getRevision();
+        builtCellSize = cellSize;
+    }
+
+    // тайл из кэша или новый (nullptr, если лимит построений в этом кадре исчерпан);
+    // тайл, отрисованный до появления новых строк, перерисовывается, пока не исчерпан лимит
+    sf::RenderTexture* acquireTile(const Maze& maze, int level, int tx, int ty, int rowLimit, int& builds) {
+        auto it = tiles.find(tileKey(level, tx, ty));
+        if (it != tiles.end()) {
+            Tile& tile = it->second;
+            tile.lastUsed = frame;
+            int span = TILE_CELLS << level;
+            if (tile.rows < min({maze.getHeight(), (ty + 1) * span, rowLimit})) { // появились новые строки
+                if (builds >= MAX_BUILDS_PER_FRAME) {
+                    pending = true;
+                    return tile.texture.get();
+                }
+                ++builds;
+                Profiler::instance().count("tiles built");
+                tile.rows = renderTile(*tile.texture, maze, level, tx, ty, rowLimit);
+            }
+            return tile.texture.get();
+        }
+        if (builds >= MAX_BUILDS_PER_FRAME) {
+            pending = true;
+            return nullptr;
+        }
+        ++builds;
+        Profiler::instance().count("tiles built");
+
+        if (tiles.size() >= MAX_TILES) { // вытесняем давно не использованный тайл
+            auto oldest = tiles.begin();
+            for (auto jt = tiles.begin(); jt != tiles.end(); ++jt) {
+                if (jt->second.lastUsed < oldest->second.lastUsed) oldest = jt;
+            }
+            freeTextures.push_back(move(oldest->second.texture));
+            tiles.erase(oldest);
+        }
+        unique_ptr<sf::RenderTexture> texture;
+        if (!freeTextures.empty()) {
+            texture = move(freeTextures.back());
+            freeTextures.pop_back();
+        } else {
+            texture.reset(new sf::RenderTexture());
+            if (!texture->create(TILE_PIXELS, TILE_PIXELS)) return nullptr;
+        }
+        int rows = renderTile(*texture, maze, level, tx, ty, rowLimit);
+        Tile& tile = tiles[tileKey(level, tx, ty)];
+        tile.texture = move(texture);
+        tile.rows = rows;
+        tile.lastUsed = frame;
+        return tile.texture.get();
+    }
+
+public:
+    // последний кадр нарисован не полностью (лимит построения тайлов): нужен еще кадр
+    bool hasPendingWork() const { return pending; }
+
+    // отрисовка видимой части лабиринта в текущем виде target (клетка - cellSize единиц мира);
+    // рисуются только строки до rowLimit (остальные еще генерируются и не читаются)
+    void draw(sf::RenderTarget& target, const Maze& maze, float cellSize, int rowLimit = INT_MAX) {
+        ProfileScope scope("draw maze");
+        ++frame;
+        pending = false;
+        if (builtMaze != &maze || builtRevision != maze.getRevision() || builtCellSize != cellSize) {
+            invalidate(maze, cellSize);
+        }
+        int width = maze.getWidth(), height = maze.getHeight();
+        if (width <= 0 || height <= 0) return;
+
+        // видимая область в клетках
+        const sf::View& view = target.getView();
+        sf::Vector2f center = view.getCenter(), size = view.getSize();
+        float pixelsPerCell = target.getSize().x * cellSize / size.x;
+        int cx0 = max(0, int(floor((center.x - size.x / 2) / cellSize)));
+        int cy0 = max(0, int(floor((center.y - size.y / 2) / cellSize)));
+        int cx1 = min(width, int(ceil((center.x + size.x / 2) / cellSize)) + 1);
+        int cy1 = min(height, int(ceil((center.y + size.y / 2) / cellSize)) + 1);
+        cy1 = min(cy1, rowLimit);
+        if (cx0 >= cx1 || cy0 >= cy1) return;
+
+        if (pixelsPerCell >= DETAIL_PIXELS) { // крупный масштаб: прямая геометрия видимых клеток
+            bool inside = detailValid && cx0 >= detailCells.left && cy0 >= detailCells.top &&
+                cx1 <= detailCells.left + detailCells.width && cy1 <= detailCells.top + detailCells.height &&
+                detailRows >= min(detailCells.top + detailCells.height, rowLimit); // новые строки не появились
+            if (!inside) { // собираем с запасом в половину экрана с каждой стороны
+                int marginX = (cx1 - cx0) / 2 + 1, marginY = (cy1 - cy0) / 2 + 1;
+                int x0 = max(0, cx0 - marginX), y0 = max(0, cy0 - marginY);
+                int x1 = min(width, cx1 + marginX), y1 = min(height, cy1 + marginY);
+                detail.clear();
+                detail.setPrimitiveType(sf::Triangles);
+                detailRows = min(y1, rowLimit);
+                appendWalls(detail, maze, x0, y0, x1, detailRows, x0 * cellSize, y0 * cellSize, cellSize, 2);
+                detailCells = sf::IntRect(x0, y0, x1 - x0, y1 - y0);
+                detailValid = true;
+            }
+            target.draw(detail);
+            Profiler::instance().count("draw calls");
+            return;
+        }
+
+        // уровень детализации: наименьший, у которого текселей на клетку не меньше пикселей на клетку
+        int maxLevel = 0;
+        while ((TILE_CELLS << maxLevel) < max(width, height)) ++maxLevel;
+        int level = 0;
+        while (level < maxLevel && float(TILE_PIXELS) / (TILE_CELLS << (level + 1)) >= pixelsPerCell) ++level;
+
+        int span = TILE_CELLS << level;
+        float tileWorld = span * cellSize; // размер тайла в единицах мира
+        int builds = 0;
+        sf::Sprite sprite;
+        sprite.setScale(tileWorld / TILE_PIXELS, tileWorld / TILE_PIXELS);
+        for (int ty = cy0 / span; ty <= (cy1 - 1) / span; ++ty) {
+            for (int tx = cx0 / span; tx <= (cx1 - 1) / span; ++tx) {
+                sf::RenderTexture* texture = acquireTile(maze, level, tx, ty, rowLimit, builds);
+                if (!texture) continue; // появится в следующих кадрах
+                sprite.setTexture(texture->getTexture(), true);
+                sprite.setPosition(tx * tileWorld, ty * tileWorld);
+                target.draw(sprite);
+                Profiler::instance().count("draw calls");
+            }
+        }
+    }
+};
+
+// камера: масштаб и перемещение вида по лабиринту
+class Camera {
+private:
+    sf::View view; // текущий вид
+    sf::Vector2f world; // размер лабиринта в единицах мира
+    float cellSize; // размер клетки в единицах мира
+
+public:
+    Camera(float worldWidth, float worldHeight, float cellSize)
+        : world(worldWidth, worldHeight), cellSize(cellSize) {}
+
+    // показать весь лабиринт в окне, сохранив пропорции
+    void fit(sf::Vector2u windowSize) {
+        float scale = max(world.x / windowSize.x, world.y / windowSize.y); // единиц мира на пиксель
+        view.setSize(windowSize.x * scale, windowSize.y * scale);
+        view.setCenter(world.x / 2, world.y / 2);
+    }
+
+    // изменение размера окна с сохранением масштаба
+    void resize(sf::Vector2u oldSize, sf::Vector2u newSize) {
+        float scale = view.getSize().x / oldSize.x;
+        view.setSize(newSize.x * scale, newSize.y * scale);
+    }
+
+    // масштабирование относительно точки экрана pixel (factor < 1 - приближение)
+    void zoomAt(const sf::RenderTarget& target, sf::Vector2i pixel, float factor) {
+        float minWidth = 4 * cellSize; // не ближе нескольких клеток
+        float maxWidth = 4 * max(world.x, world.y * view.getSize().x / view.getSize().y);
+        float newWidth = view.getSize().x * factor;
+        if (newWidth < minWidth || newWidth > maxWidth) return;
+        sf::Vector2f before = target.mapPixelToCoords(pixel, view);
+        view.zoom(factor);
+        sf::Vector2f after = target.mapPixelToCoords(pixel, view);
+        view.move(before - after); // точка под курсором остается на месте
+    }
+
+    // перемещение вида на заданное число пикселей экрана
+    void pan(const sf::RenderTarget& target, sf::Vector2i fromPixel, sf::Vector2i toPixel) {
+        view.move(target.mapPixelToCoords(fromPixel, view) - target.mapPixelToCoords(toPixel, view));
+    }
+
+    const sf::View& getView() const { return view; }
+};
+
+// пакетная отрисовка пути и маркеров начала/конца: все фигуры собираются в один
+// sf::VertexArray при изменении и выводятся одним вызовом draw
+class OverlayRenderer {
+private:
+    sf::VertexArray shapes; // треугольники всех фигур
+
+public:
+    OverlayRenderer() : shapes(sf::Triangles) {}
+
+    // очистка перед новой сборкой
+    void clear() { shapes.clear(); }
+
+    // путь: квадраты в центрах клеток (без начальной и конечной точки)
+    void addPath(const vector<pair<int, int>>& path, float cellSize, sf::Color color) {
+        for (size_t i = 1; i + 1 < path.size(); ++i) { // проходим по всем ячейкам
+            appendRect(shapes, path[i].first * cellSize + cellSize / 2 - cellSize / 8,
+                path[i].second * cellSize + cellSize / 2 - cellSize / 8, cellSize / 4, cellSize / 4, color);
+        }
+    }
+
+    // маркер точки: круг радиусом в четверть клетки в центре клетки (x, y)
+    void addMarker(int x, int y, float cellSize, sf::Color color) {
+        const int SEGMENTS = 24; // число сегментов окружности
+        const float PI = 3.14159265f;
+        float cx = x * cellSize + cellSize / 2; // центр круга
+        float cy = y * cellSize + cellSize / 2;
+        float radius = cellSize / 4;
+        for (int i = 0; i < SEGMENTS; ++i) {
+            float a0 = 2 * PI * i / SEGMENTS;
+            float a1 = 2 * PI * (i + 1) / SEGMENTS;
+            shapes.append(sf::Vertex(sf::Vector2f(cx, cy), color));
+            shapes.append(sf::Vertex(sf::Vector2f(cx + radius * cos(a0), cy + radius * sin(a0)), color));
+            shapes.append(sf::Vertex(sf::Vector2f(cx + radius * cos(a1), cy + radius * sin(a1)), color));
+        }
+    }
+
+    void draw(sf::RenderTarget& target) const {
+        target.draw(shapes);
+        Profiler::instance().count("draw calls");
+    }
+};
+
+// отображение хода пошагового поиска в одной текстуре, как у тепловой карты: тексель - клетка
+// (или блок клеток, если лабиринт больше MAX_PIXELS). за кадр перекрашиваются только новые
+// раскрытые клетки и старый и новый фронт, в текстуру загружается полоса измененных строк.
+// память - 4 байта цвета и байт состояния на тексель, рисование - один спрайт при любом размере поиска
+class SearchRenderer {
+private:
+    static constexpr int MAX_PIXELS = 2048; // наибольшая сторона текстуры
+    static constexpr uint8_t VISITED = 1, FRONTIER = 2; // биты состояния текселя
+    sf::Image image;
+    sf::Texture texture;
+    sf::Sprite sprite;
+    vector<uint8_t> state; // состояние текселя
+    vector<unsigned> frontier; // тексели текущего фронта
+    int width = 0, height = 0; // размер лабиринта, для которого создана текстура
+    int block = 1; // клеток на тексель по каждой стороне
+    unsigned columns = 0; // ширина текстуры
+    bool active = false; // текстура относится к текущему поиску
+    unsigned dirtyFirst = 0, dirtyLast = 0; // полоса измененных строк текстуры [first, last)
+
+    void paint(unsigned texel) {
+        uint8_t bits = state[texel];
+        sf::Color color = bits & FRONTIER ? sf::Color(230, 200, 40, 180)
+            : bits & VISITED ? sf::Color(40, 70, 160, 140) : sf::Color::Transparent;
+        unsigned row = texel / columns;
+        image.setPixel(texel % columns, row, color);
+        dirtyFirst = min(dirtyFirst, row);
+        dirtyLast = max(dirtyLast, row + 1);
+    }
+
+    unsigned texelOf(int cell) const {
+        return unsigned((cell / width) / block) * columns + unsigned((cell % width) / block);
+    }
+
+    // новая прозрачная текстура под лабиринт width x height
+    void reset(int mazeWidth, int mazeHeight, float cellSize) {
+        width = mazeWidth;
+        height = mazeHeight;
+        block = 1;
+        while ((width + block - 1) / block > MAX_PIXELS || (height + block - 1) / block > MAX_PIXELS) block *= 2;
+        columns = unsigned((width + block - 1) / block);
+        unsigned rows = unsigned((height + block - 1) / block);
+        image.create(columns, rows, sf::Color::Transparent);
+        texture.loadFromImage(image);
+        sprite.setTexture(texture, true);
+        sprite.setScale(cellSize * block, cellSize * block);
+        state.assign(size_t(columns) * rows, 0);
+        frontier.clear();
+        active = true;
+    }
+
+public:
+    void clear() { active = false; }
+
+    // добавление раскрытых с прошлого кадра ячеек и замена фронта (ячейки - индексы y * mazeWidth + x)
+    void update(const vector<int>& expanded, const vector<int>& front, int mazeWidth, int mazeHeight, float cellSize) {
+        if (mazeWidth <= 0 || mazeHeight <= 0) return;
+        if (!active || mazeWidth != width || mazeHeight != height) reset(mazeWidth, mazeHeight, cellSize);
+        dirtyFirst = UINT_MAX;
+        dirtyLast = 0;
+        for (unsigned texel : frontier) { // старый фронт
+            state[texel] &= uint8_t(~FRONTIER);
+            paint(texel);
+        }
+        frontier.clear();
+        for (int cell : expanded) {
+            unsigned texel = texelOf(cell);
+            state[texel] |= VISITED;
+            paint(texel);
+        }
+        for (int cell : front) {
+            unsigned texel = texelOf(cell);
+            if (state[texel] & FRONTIER) continue;
+            state[texel] |= FRONTIER;
+            frontier.push_back(texel);
+            paint(texel);
+        }
+        if (dirtyFirst < dirtyLast) { // загружаем только полосу измененных строк
+            texture.update(image.getPixelsPtr() + size_t(dirtyFirst) * columns * 4, columns, dirtyLast - dirtyFirst, 0, dirtyFirst);
+        }
+    }
+
+    void draw(sf::RenderTarget& target) const {
+        if (!active) return;
+        target.draw(sprite);
+        Profiler::instance().count("draw calls");
+    }
+};
+
+// тепловая карта поля расстояний в одной текстуре: тексель - клетка (или блок клеток, если
+// лабиринт больше MAX_PIXELS), цвет - расстояние от источника (синий - близко, красный - далеко).
+// текстура пересобирается, только когда достроено поле с другим источником или по другой версии лабиринта
+class HeatmapRenderer {
+private:
+    static constexpr int MAX_PIXELS = 2048; // наибольшая сторона текстуры
+    sf::Image image;
+    sf::Texture texture;
+    sf::Sprite sprite;
+    bool ready = false; // текстура собрана
+    uint64_t builtRevision = 0; // для какой версии лабиринта
+    int builtSource = -1; // и какого источника
+
+    // цвет доли t (0..1) шкалы: синий - голубой - зеленый - желтый - красный
+    static sf::Color gradient(float t) {
+        auto channel = [](float value) { return sf::Uint8(max(0.0f, min(1.0f, value)) * 255); };
+        if (t < 0.25f) return sf::Color(0, channel(4 * t), 255, 150);
+        if (t < 0.5f) return sf::Color(0, 255, channel(2 - 4 * t), 150);
+        if (t < 0.75f) return sf::Color(channel(4 * t - 2), 255, 0, 150);
+        return sf::Color(255, channel(4 - 4 * t), 0, 150);
+    }
+
+public:
+    // пересборка по достроенному полю, если оно изменилось (true - текстура пересобрана)
+    bool update(const DistanceField& field, float cellSize) {
+        if (!field.isComplete()) return false;
+        if (ready && builtRevision == field.getRevision() && builtSource == field.getSource()) return false;
+        int width = field.getWidth(), height = field.getHeight();
+        int block = 1; // клеток на тексель по каждой стороне
+        while ((width + block - 1) / block > MAX_PIXELS || (height + block - 1) / block > MAX_PIXELS) block *= 2;
+        image.create(unsigned((width + block - 1) / block), unsigned((height + block - 1) / block), sf::Color::Transparent);
+        float scale = 1.0f / float(max(1, field.getMaxDistance()));
+        for (int y = 0; y < height; y += block) {
+            for (int x = 0; x < width; x += block) { // тексель берет расстояние угловой клетки блока
+                int distance = field.distance(x, y);
+                if (distance >= 0) image.setPixel(unsigned(x / block), unsigned(y / block), gradient(distance * scale));
+            }
+        }
+        texture.loadFromImage(image);
+        sprite.setTexture(texture, true);
+        sprite.setScale(cellSize * block, cellSize * block);
+        builtRevision = field.getRevision();
+        builtSource = field.getSource();
+        ready = true;
+        return true;
+    }
+
+    // карта собрана для поля от source по версии revision
+    bool isReadyFor(uint64_t revision, int source) const {
+        return ready && builtRevision == revision && builtSource == source;
+    }
+
+    void draw(sf::RenderTarget& target) const {
+        if (!ready) return;
+        target.draw(sprite);
+        Profiler::instance().count("draw calls");
+    }
+};
+
+// экранная сводка профилировщика (таймеры и счетчики) поверх вида в пикселях окна.
+// шрифт ищется среди системных; если его нет, hasFont() == false и сводку можно
+// показывать строкой summary() (например, в заголовке окна)
+class ProfilerHud {
+private:
+    sf::Font font;
+    bool fontLoaded = false;
+    sf::Text text;
+    sf::VertexArray background;
+
+public:
+    ProfilerHud() : background(sf::Triangles) {
+        const char* candidates[] = {
+            "DejaVuSansMono.ttf",
+            "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
+            "/usr/share/fonts/TTF/DejaVuSansMono.ttf",
+            "/Library/Fonts/Courier New.ttf",
+            "C:/Windows/Fonts/consola.ttf",
+        };
+        for (const char* path : candidates) {
+            if (font.loadFromFile(path)) {
+                fontLoaded = true;
+                break;
+            }
+        }
+        text.setFont(font);
+        text.setCharacterSize(14);
+        text.setFillColor(sf::Color::White);
+    }
+
+    bool hasFont() const { return fontLoaded; }
+
+    // сводка: по строке на таймер (последний, средний и наибольший замер) и счетчик
+    // (за последний кадр и всего); separator разделяет записи
+    static string summary(const char* separator) {
+        string result;
+        char line[160];
+        for (const auto& entry : Profiler::instance().getTimers()) {
+            const Profiler::Timer& timer = entry.second;
+            snprintf(line, sizeof(line), "%-12s %8.2f ms  avg %8.2f  max %8.2f  n %llu", entry.first.c_str(),
+                timer.lastMs, timer.totalMs / double(max<uint64_t>(1, timer.count)), timer.maxMs,
+                (unsigned long long)timer.count);
+            result += line;
+            result += separator;
+        }
+        for (const auto& entry : Profiler::instance().getCounters()) {
+            snprintf(line, sizeof(line), "%-15s %10llu /frame  %14llu total", entry.first.c_str(),
+                (unsigned long long)entry.second.lastFrame, (unsigned long long)entry.second.total);
+            result += line;
+            result += separator;
+        }
+        return result;
+    }
+
+    // отрисовка в левом верхнем углу окна (вид target временно заменяется экранным)
+    void draw(sf::RenderTarget& target) {
+        if (!fontLoaded) return;
+        sf::View previous = target.getView();
+        sf::Vector2u size = target.getSize();
+        target.setView(sf::View(sf::FloatRect(0, 0, float(size.x), float(size.y))));
+        text.setString(summary("\n"));
+        text.setPosition(8, 8);
+        sf::FloatRect bounds = text.getLocalBounds();
+        background.clear();
+        appendRect(background, 0, 0, bounds.left + bounds.width + 16, bounds.top + bounds.height + 16, sf::Color(0, 0, 0, 190));
+        target.draw(background);
+        target.draw(text);
+        target.setView(previous);
+    }
+};
@@ -1,93 +1,199 @@
 #pragma once
-#include <SFML/Graphics.hpp>
 #include <vector>
 #include <random>
-#include <stack>
+#include <climits>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <fstream>
+#include <string>
+#include <memory>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <atomic>
+#include "Profiler.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAZE_HAS_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
-// класс ячейки лабиринта, представляет собой базовый строительный блок
-class Cell {
+// ячейка лабиринта - лёгкий прокси над битовой сеткой Maze, отдельно в памяти не хранится
+// (MazeT = Maze для изменяемой ячейки, const Maze - для ячейки только для чтения)
+template <class MazeT>
+class BasicCell {
 private:
-    int x, y; // координаты каждой ячейки
-    bool walls[4]; // массив стен: 0-верхняя, 1-правая, 2-нижняя, 3-левая
-    int set; // идентификатор множества для алгоритма Эллера
-    bool visited; // флаг для отслеживания посещенных ячеек при поиске пути
+    MazeT* maze; // лабиринт, которому принадлежит ячейка
+    int x, y; // координаты ячейки
 
 public:
-    // конструктор ячейки, инициализирует координаты и устанавливает все стены
-    Cell(int x = 0, int y = 0) : x(x), y(y), set(-1), visited(false) {  // устанавливаем координаты
-        for (int i = 0; i < 4; ++i) walls[i] = true;  // устанавливаем все стены
-    }
-    
-    // методы для работы со стенами ячейки
-    void setWall(int direction, bool state) { walls[direction] = state; }
-    bool hasWall(int direction) const { return walls[direction]; }
-    
-    // методы для работы с множеством Эллера
-    void setSet(int newSet) { set = newSet; }
-    int getSet() const { return set; }
-    
-    // методы для отслеживания посещенных ячеек
-    void setVisited(bool state) { visited = state; }
-    bool isVisited() const { return visited; }
-    
+    BasicCell(MazeT& maze, int x, int y) : maze(&maze), x(x), y(y) {}
+
+    // методы для работы со стенами ячейки: 0-верхняя, 1-правая, 2-нижняя, 3-левая
+    void setWall(int direction, bool state) const { maze->setWall(x, y, direction, state); }
+    bool hasWall(int direction) const { return maze->hasWall(x, y, direction); }
+
     // получение координат ячейки
     int getX() const { return x; }
     int getY() const { return y; }
-    
-    // метод отрисовки ячейки в окне SFML
-    void draw(sf::RenderWindow& window, float cellSize) const {
-        float xPos = x * cellSize; // позиция по x (cellSize - размер клетки)
-        float yPos = y * cellSize; // позиция по y
-        
-        // отрисовка верхней стены
-        if (walls[0]) {
-            sf::RectangleShape northWall(sf::Vector2f(cellSize, 2)); // создаем прямоугольник для отрисовки (sf::Vector2f(ширина, высота))
-            northWall.setPosition(xPos, yPos); // устанавливаем позицию
-            northWall.setFillColor(sf::Color::White); // устанавливаем цвет
-            window.draw(northWall); // отрисовываем
-        }
-        // отрисовка правой стены
-        if (walls[1]) {
-            sf::RectangleShape eastWall(sf::Vector2f(2, cellSize));
-            eastWall.setPosition(xPos + cellSize, yPos);
-            eastWall.setFillColor(sf::Color::White);
-            window.draw(eastWall);
-        }
-        // отрисовка нижней стены
-        if (walls[2]) {
-            sf::RectangleShape southWall(sf::Vector2f(cellSize, 2));
-            southWall.setPosition(xPos, yPos + cellSize);
-            southWall.setFillColor(sf::Color::White);
-            window.draw(southWall);
-        }
-        // отрисовка левой стены
-        if (walls[3]) {
-            sf::RectangleShape westWall(sf::Vector2f(2, cellSize));
-            westWall.setPosition(xPos, yPos);
-            westWall.setFillColor(sf::Color::White);
-            window.draw(westWall);
-        }
+};
+
+// число единичных бит в слове
+inline int popCount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for (; word; word &= word - 1) ++count;
+    return count;
+#endif
+}
+
+// индекс младшего единичного бита (word != 0)
+inline int lowestBit64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int index = 0;
+    while (!(word & 1)) { word >>= 1; ++index; }
+    return index;
+#endif
+}
+
+// перемешивание 64-битного числа (splitmix64): из зерна и счетчика получаются независимые
+// случайные слова, результат одинаков на всех платформах
+inline uint64_t mixBits64(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+// направления: 0-вверх, 1-вправо, 2-вниз, 3-влево (совпадают с номерами стен ячейки)
+struct Directions {
+    static constexpr int dx[4] = {0, 1, 0, -1}; // смещения по x
+    static constexpr int dy[4] = {-1, 0, 1, 0}; // смещения по y
+
+    static constexpr int opposite(int direction) { return direction ^ 2; }
+
+    // направление хода на соседнюю клетку со смещением (dx, dy)
+    static constexpr int between(int dx, int dy) { return dx == 1 ? 1 : dx == -1 ? 3 : dy == 1 ? 2 : 0; }
+};
+static_assert(Directions::between(Directions::dx[3], Directions::dy[3]) == 3, "direction table mismatch");
+static_assert(Directions::opposite(1) == 3, "direction table mismatch");
+
+// каким генератором получен лабиринт: вместе с зерном и размером этого достаточно,
+// чтобы получить тот же лабиринт заново
+enum class MazeGeneratorKind : uint8_t {
+    Unknown = 0, // не записан (файлы, сохраненные до появления поля)
+    Eller = 1, // EllerMazeGenerator, последовательный режим случайных бит
+    EllerCounter = 2, // EllerMazeGenerator, счетный режим
+    ParallelBlocks = 3 // ParallelBlockMazeGenerator (разбиение на блоки зависит от числа потоков)
+};
+
+// заголовок бинарного файла лабиринта (версия 1), 64 байта. за ним с dataOffset идут
+// строки: на строку wordsPerRow слов правых стен, затем wordsPerRow слов нижних стен
+struct MazeFileHeader {
+    static constexpr uint32_t MAGIC = 0x455A414D; // "MAZE"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t ORDER_MARK = 0x01020304; // проверка порядка байт
+
+    uint32_t magic = MAGIC;
+    uint32_t version = VERSION;
+    uint32_t byteOrder = ORDER_MARK;
+    uint32_t width = 0; // ширина в ячейках
+    uint32_t height = 0; // высота в ячейках
+    uint8_t generator = 0; // MazeGeneratorKind
+    uint8_t reserved = 0;
+    uint16_t generatorThreads = 0; // число потоков ParallelBlockMazeGenerator
+    uint64_t seed = 0; // зерно генерации
+    uint64_t wordsPerRow = 0; // 64-битных слов на битовый ряд
+    uint64_t dataOffset = sizeof(MazeFileHeader); // смещение битов стен (кратно 8)
+    uint8_t padding[16] = {};
+
+    MazeFileHeader() = default;
+    MazeFileHeader(int width, int height, uint64_t seed,
+        MazeGeneratorKind generator = MazeGeneratorKind::Unknown, unsigned generatorThreads = 0)
+        : width(uint32_t(width)), height(uint32_t(height)), generator(uint8_t(generator)),
+          generatorThreads(uint16_t(min(generatorThreads, 0xFFFFu))), seed(seed),
+          wordsPerRow((uint64_t(width) + 63) / 64) {}
+
+    // размер битов стен в байтах
+    uint64_t dataSize() const { return wordsPerRow * 2 * height * sizeof(uint64_t); }
+
+    // проверка заголовка прочитанного файла
+    void validate(uint64_t fileSize) const {
+        if (magic != MAGIC) throw runtime_error("not a maze file");
+        if (byteOrder != ORDER_MARK) throw runtime_error("maze file has foreign byte order");
+        if (version != VERSION) throw runtime_error("unsupported maze file version");
+        if (width > uint32_t(INT32_MAX) || height > uint32_t(INT32_MAX) ||
+            wordsPerRow != (uint64_t(width) + 63) / 64 || dataOffset % sizeof(uint64_t) != 0)
+            throw runtime_error("corrupt maze file header");
+        if (fileSize < dataOffset || fileSize - dataOffset < dataSize())
+            throw runtime_error("truncated maze file");
     }
 };
+static_assert(sizeof(MazeFileHeader) == 64, "maze file header must be 64 bytes");
 
-// базовый класс лабиринта, содержит сетку ячеек и основные методы работы с ней
+class Maze;
+using Cell = BasicCell<Maze>; // изменяемая ячейка
+using ConstCell = BasicCell<const Maze>; // ячейка только для чтения
+
+// базовый класс лабиринта, хранит стены в одном непрерывном битовом буфере
+//
+// каждая общая стена хранится один раз: ячейка владеет своей правой и нижней стеной,
+// левая и верхняя берутся у соседей. строка y занимает 2 * wordsPerRow слов:
+// сначала биты правых стен, затем биты нижних стен (бит x в слове x / 64).
+// внешняя граница лабиринта всегда закрыта и не меняется.
+//
+// биты могут лежать в собственном буфере или в отображенном в память файле (Maze::open),
+// который читается без копирования; первая запись в такой лабиринт копирует биты в свой буфер.
 class Maze {
 protected:
-    vector<vector<Cell>> grid; // двумерный массив ячеек лабиринта
+    vector<uint64_t> walls; // собственный буфер битов стен (1 - стена есть)
+    shared_ptr<const uint64_t> mapped; // биты стен в отображенном файле (только чтение)
     int width; // ширина лабиринта в ячейках
     int height; // высота лабиринта в ячейках
-    
-public:
-    // конструктор лабиринта, создает сетку заданного размера
-    Maze(int width, int height) : width(width), height(height) { // устанавливаем размер
-        grid.resize(height, vector<Cell>(width)); // создаем двумерный массив
-        for (int y = 0; y < height; ++y) { // заполняем ячейки
-            for (int x = 0; x < width; ++x) {
-                grid[y][x] = Cell(x, y); // создаем ячейку
-            }
+    size_t wordsPerRow; // количество 64-битных слов на один битовый ряд строки
+    uint64_t seed; // зерно, с которым лабиринт сгенерирован
+    MazeGeneratorKind generatorKind; // каким генератором
+    unsigned generatorThreads; // с каким числом потоков (для ParallelBlocks)
+    uint64_t revision; // номер версии содержимого, меняется при любом изменяющем доступе
+
+    // глобальный счетчик версий: разные лабиринты и их состояния не получают одинаковых номеров
+    static uint64_t nextRevision() {
+        static atomic<uint64_t> counter{0};
+        return ++counter;
+    }
+
+    const uint64_t* words() const { return mapped ? mapped.get() : walls.data(); }
+    uint64_t* words() {
+        revision = nextRevision(); // содержимое может измениться - кэши по старой версии устаревают
+        if (mapped) { // копирование при первой записи в отображенный лабиринт
+            walls.assign(mapped.get(), mapped.get() + wordsPerRow * 2 * size_t(height));
+            mapped.reset();
         }
+        return walls.data();
+    }
+
+    static void assignBit(uint64_t* row, int x, bool state) {
+        uint64_t mask = uint64_t(1) << (x & 63);
+        if (state) row[x >> 6] |= mask;
+        else row[x >> 6] &= ~mask;
+    }
+
+public:
+    // конструктор лабиринта, создает сетку заданного размера со всеми стенами
+    Maze(int width, int height)
+        : width(width), height(height), wordsPerRow((size_t(max(width, 0)) + 63) / 64), seed(0),
+          generatorKind(MazeGeneratorKind::Unknown), generatorThreads(0), revision(nextRevision()) {
+        walls.assign(wordsPerRow * 2 * size_t(max(height, 0)), ~uint64_t(0)); // все стены на месте
     }
     
     virtual ~Maze() = default; // деструктор для освобождения памяти
@@ -98,38 +204,186 @@ public:
     }
     
     // методы доступа к ячейкам
-    const Cell& getCell(int x, int y) const { return grid[y][x]; } // получение ячейки по координатам
-    Cell& getCell(int x, int y) { return grid[y][x]; } // получение ячейки по координатам
+    ConstCell getCell(int x, int y) const { return ConstCell(*this, x, y); } // получение ячейки по координатам
+    Cell getCell(int x, int y) { return Cell(*this, x, y); } // получение ячейки по координатам
+
+    // проверка стены ячейки (x, y) в направлении direction
+    bool hasWall(int x, int y, int direction) const {
+        switch (direction) {
+        case 0: return y == 0 || testBit(southWalls(y - 1), x); // верхняя - нижняя стена соседа сверху
+        case 1: return testBit(eastWalls(y), x); // правая
+        case 2: return testBit(southWalls(y), x); // нижняя
+        default: return x == 0 || testBit(eastWalls(y), x - 1); // левая - правая стена соседа слева
+        }
+    }
+
+    // установка стены ячейки (x, y), внешняя граница не меняется
+    void setWall(int x, int y, int direction, bool state) {
+        switch (direction) {
+        case 0: if (y > 0) assignBit(southWalls(y - 1), x, state); break;
+        case 1: if (x < width - 1) assignBit(eastWalls(y), x, state); break;
+        case 2: if (y < height - 1) assignBit(southWalls(y), x, state); break;
+        default: if (x > 0) assignBit(eastWalls(y), x - 1, state); break;
+        }
+    }
+
+    // бит ячейки x в битовом ряду row (1 - стена): раскладка рядов для всех, кто читает их напрямую
+    static bool testBit(const uint64_t* row, int x) { return (row[x >> 6] >> (x & 63)) & 1; }
+
+    // прямой доступ к битовым рядам строки y (для генераторов и пакетной обработки)
+    const uint64_t* eastWalls(int y) const { return words() + size_t(y) * 2 * wordsPerRow; }
+    uint64_t* eastWalls(int y) { return words() + size_t(y) * 2 * wordsPerRow; }
+    const uint64_t* southWalls(int y) const { return eastWalls(y) + wordsPerRow; }
+    uint64_t* southWalls(int y) { return eastWalls(y) + wordsPerRow; }
+    size_t getWordsPerRow() const { return wordsPerRow; }
     
     // получение размеров лабиринта
     int getWidth() const { return width; } // получение ширины лабиринта
     int getHeight() const { return height; } // получение высоты лабиринта
+
+    // зерно генерации, сохраняется вместе с лабиринтом
+    uint64_t getSeed() const { return seed; }
+    void setSeed(uint64_t newSeed) { seed = newSeed; }
+
+    // генератор лабиринта, тоже сохраняется: одного зерна мало, чтобы повторить лабиринт
+    MazeGeneratorKind getGeneratorKind() const { return generatorKind; }
+    unsigned getGeneratorThreads() const { return generatorThreads; }
+    void setGenerator(MazeGeneratorKind kind, unsigned threads = 0) {
+        generatorKind = kind;
+        generatorThreads = threads;
+    }
+
+    // версия содержимого: по ней кэши (геометрия, индексы) узнают, что лабиринт изменился
+    uint64_t getRevision() const { return revision; }
+
+    // новая версия без изменяющего доступа: после записи стен через полученные ранее указатели
+    // (например, из фонового потока), чтобы кэши, построенные во время записи, устарели
+    void touch() { revision = nextRevision(); }
+
+    // лабиринт читается прямо из отображенного файла
+    bool isMapped() const { return bool(mapped); }
+
+    // сохранение в бинарный файл (см. MazeFileHeader). запись идет во временный файл рядом
+    // с целевым, который затем переименовывается поверх: так можно сохранить лабиринт в тот
+    // же файл, из которого он отображен (усечение файла испортило бы отображение)
+    void save(const string& path) const {
+        string temporary = path + ".tmp";
+        {
+            ofstream out(temporary, ios::binary | ios::trunc);
+            if (!out) throw runtime_error("cannot create maze file: " + temporary);
+            MazeFileHeader header(width, height, seed, generatorKind, generatorThreads);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(words()), header.dataSize());
+            out.close();
+            if (out.fail()) {
+                std::remove(temporary.c_str());
+                throw runtime_error("cannot write maze file: " + path);
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+#ifdef _WIN32
+            // на Windows rename не заменяет существующий файл
+            std::remove(path.c_str());
+            if (std::rename(temporary.c_str(), path.c_str()) == 0) return;
+#endif
+            std::remove(temporary.c_str()); // целевой файл остается прежним
+            throw runtime_error("cannot replace maze file: " + path);
+        }
+    }
+
+    // открытие бинарного файла: на POSIX файл отображается в память только для чтения
+    // и используется без копирования, иначе читается целиком
+    static Maze open(const string& path) {
+        Maze maze(0, 0);
+        MazeFileHeader header;
+#ifdef MAZE_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw runtime_error("cannot open maze file: " + path);
+        struct stat info;
+        if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(header)) {
+            ::close(fd);
+            throw runtime_error("cannot read maze file: " + path);
+        }
+        size_t length = size_t(info.st_size);
+        void* base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // отображение остается действительным и после закрытия
+        if (base == MAP_FAILED) throw runtime_error("cannot map maze file: " + path);
+        memcpy(&header, base, sizeof(header));
+        try {
+            header.validate(length);
+        } catch (...) {
+            munmap(base, length);
+            throw;
+        }
+        const uint64_t* data = reinterpret_cast<const uint64_t*>(
+            static_cast<const char*>(base) + header.dataOffset);
+        maze.mapped = shared_ptr<const uint64_t>(data, [base, length](const uint64_t*) { munmap(base, length); });
+#else
+        ifstream in(path, ios::binary | ios::ate);
+        if (!in) throw runtime_error("cannot open maze file: " + path);
+        uint64_t length = uint64_t(in.tellg());
+        in.seekg(0);
+        if (length < sizeof(header) || !in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            throw runtime_error("cannot read maze file: " + path);
+        header.validate(length);
+        maze.walls.resize(header.wordsPerRow * 2 * header.height);
+        in.seekg(header.dataOffset);
+        if (!in.read(reinterpret_cast<char*>(maze.walls.data()), header.dataSize()))
+            throw runtime_error("cannot read maze file: " + path);
+#endif
+        maze.width = int(header.width);
+        maze.height = int(header.height);
+        maze.wordsPerRow = size_t(header.wordsPerRow);
+        maze.seed = header.seed;
+        maze.generatorKind = header.generator <= uint8_t(MazeGeneratorKind::ParallelBlocks)
+            ? MazeGeneratorKind(header.generator) : MazeGeneratorKind::Unknown;
+        maze.generatorThreads = header.generatorThreads;
+        maze.revision = nextRevision();
+        if (!maze.hasClosedBorder()) throw runtime_error("corrupt maze file (open border): " + path);
+        return maze;
+    }
+
+    // внешняя граница и биты за шириной строки - стены: обход соседей (forEachOpenNeighbor,
+    // OpenNeighbors) на этом основан и не проверяет выход за правый и нижний край
+    bool hasClosedBorder() const {
+        if (width <= 0 || height <= 0) return true;
+        size_t last = wordsPerRow - 1;
+        uint64_t east = ~uint64_t(0) << ((width - 1) & 63); // правая стена последнего столбца и биты за ним
+        uint64_t padding = east << 1; // биты за шириной строки
+        for (int y = 0; y < height; ++y) {
+            if ((eastWalls(y)[last] & east) != east || (southWalls(y)[last] & padding) != padding) return false;
+        }
+        const uint64_t* bottom = southWalls(height - 1);
+        for (size_t w = 0; w < wordsPerRow; ++w) {
+            if (bottom[w] != ~uint64_t(0)) return false;
+        }
+        return true;
+    }
     
+    // обход соседей, в которые можно пройти из (x, y), без выделения памяти:
+    // visit(nx, ny) вызывается в порядке вверх, вправо, вниз, влево
+    template <class Visitor>
+    void forEachOpenNeighbor(int x, int y, Visitor&& visit) const {
+        if (y > 0 && !testBit(southWalls(y - 1), x)) visit(x, y - 1);
+        if (!testBit(eastWalls(y), x)) visit(x + 1, y); // у последнего столбца правая стена есть всегда
+        if (!testBit(southWalls(y), x)) visit(x, y + 1); // у последней строки нижняя стена есть всегда
+        if (x > 0 && !testBit(eastWalls(y), x - 1)) visit(x - 1, y);
+    }
+
     // получение списка соседних ячеек для заданной позиции
     vector<pair<int, int>> getNeighbors(int x, int y) const {
         vector<pair<int, int>> neighbors; // список соседних ячейк
-        const int dx[] = {0, 1, 0, -1};  // смещения по x для четырех направлений
-        const int dy[] = {-1, 0, 1, 0};  // смещения по y для четырех направлений
         
         // проверяем все четыре направления
         for (int i = 0; i < 4; ++i) {
-            int newX = x + dx[i]; // новые координаты
-            int newY = y + dy[i];
+            int newX = x + Directions::dx[i]; // новые координаты
+            int newY = y + Directions::dy[i];
             if (isValidCell(newX, newY)) { // если координаты в пределах лабиринта
                 neighbors.push_back({newX, newY}); // добавляем соседнюю ячейку
             }
         }
         return neighbors; // возвращаем список соседних ячейк
     }
-    
-    // отрисовка всего лабиринта
-    void draw(sf::RenderWindow& window, float cellSize) const {
-        for (const auto& row : grid) {
-            for (const auto& cell : row) {
-                cell.draw(window, cellSize);
-            }
-        }
-    }
 };
 
 // интерфейс для стратегий генерации лабиринта
@@ -139,226 +393,1122 @@ public:
     virtual void generate(Maze& maze) = 0; // чисто виртуальный метод для генерации лабиринта
 };
 
+// приемник строк для потоковой генерации: строки приходят по порядку, сверху вниз
+class IMazeRowSink {
+public:
+    virtual ~IMazeRowSink() = default;
+    // строка y: биты правых и нижних стен (по words слов, формат строки как в Maze);
+    // возвращает false, чтобы прервать генерацию
+    virtual bool writeRow(int y, const uint64_t* east, const uint64_t* south, size_t words) = 0;
+};
+
+// приемник строк, передающий их в произвольную функцию
+class CallbackRowSink : public IMazeRowSink {
+private:
+    function<bool(int, const uint64_t*, const uint64_t*, size_t)> callback;
+
+public:
+    explicit CallbackRowSink(function<bool(int, const uint64_t*, const uint64_t*, size_t)> callback)
+        : callback(move(callback)) {}
+
+    bool writeRow(int y, const uint64_t* east, const uint64_t* south, size_t words) override {
+        return callback(y, east, south, words);
+    }
+};
+
+// приемник строк, записывающий их в бинарный файл лабиринта (тот же формат, что Maze::save),
+// результат можно открыть через Maze::open. после последней строки нужно вызвать finish():
+// ошибки сброса буфера и закрытия файла видны только там
+class FileRowSink : public IMazeRowSink {
+private:
+    ofstream out; // выходной файл
+
+public:
+    FileRowSink(const string& path, int width, int height, uint64_t seed = 0,
+        MazeGeneratorKind generator = MazeGeneratorKind::Unknown)
+        : out(path, ios::binary | ios::trunc) {
+        MazeFileHeader header(width, height, seed, generator);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    bool isOpen() const { return bool(out); }
+
+    bool writeRow(int, const uint64_t* east, const uint64_t* south, size_t words) override {
+        out.write(reinterpret_cast<const char*>(east), words * sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(south), words * sizeof(uint64_t));
+        return bool(out); // ошибка записи прерывает генерацию
+    }
+
+    // завершение записи: сброс буфера и закрытие файла; false - файл записан не полностью
+    bool finish() {
+        out.flush();
+        bool written = bool(out);
+        out.close();
+        return written && !out.fail();
+    }
+};
+
 // конкретная реализация генератора лабиринта, использующая алгоритм Эллера
+//
+// множества текущей строки хранятся без идентификаторов: ячейки одного множества
+// связаны в циклический список, упорядоченный по x (left/right). благодаря планарности
+// множества в строке не пересекаются, поэтому соседи x и x + 1 лежат в одном множестве
+// тогда и только тогда, когда right[x] == x + 1, а слияние и исключение ячейки - O(1).
+// вся строка обрабатывается за O(W) без выделения памяти.
 class EllerMazeGenerator : public IMazeGenerator {
+public:
+    // источник случайных бит
+    enum class RandomMode {
+        Sequential, // один поток mt19937_64 на весь лабиринт
+        Counter // слово с номером k строки y = mixBits64(ключ строки + k): любая строка считается отдельно
+    };
+
 private:
-    mt19937 rng; // генератор случайных чисел
-    int nextSet; // следующий доступный идентификатор множества
-    
-    // инициализация строки лабиринта, назначение множеств непомеченным ячейкам
-    void initializeRow(Maze& maze, int row) {
-        for (int x = 0; x < maze.getWidth(); ++x) { // проходим по всем ячейкам
-            if (maze.getCell(x, row).getSet() == -1) { // если ячейка не помечена
-                maze.getCell(x, row).setSet(nextSet++); // назначаем ей новое множество
-            }
+    uint64_t seed; // зерно следующей генерации
+    uint64_t streamSeed; // зерно текущей генерации
+    RandomMode mode; // источник случайных бит
+    mt19937_64 rng; // генератор случайных чисел (последовательный режим)
+    uint64_t rowKey; // ключ текущей строки (счетный режим)
+    uint64_t counter; // номер следующего слова строки (счетный режим)
+    uint64_t bitPool; // запас случайных бит (одно слово дает 64 решения)
+    int bitsLeft; // сколько бит осталось в запасе
+    vector<int> left; // предыдущая ячейка того же множества в строке (циклически)
+    vector<int> right; // следующая ячейка того же множества в строке (циклически)
+
+    // случайное решение "да/нет" с вероятностью 1/2
+    bool randomBit() {
+        if (bitsLeft == 0) { // запас исчерпан
+            bitPool = mode == RandomMode::Counter ? mixBits64(rowKey + counter++ * 0xD1B54A32D192ED03ull) : rng();
+            bitsLeft = 64;
+        }
+        bool bit = bitPool & 1;
+        bitPool >>= 1;
+        --bitsLeft;
+        return bit;
+    }
+
+    // начало генерации: поток случайных бит определяется только зерном
+    void beginStream() {
+        streamSeed = seed;
+        seed = mixBits64(seed); // следующая генерация даст другой лабиринт
+        rng.seed(streamSeed);
+        bitsLeft = 0;
+    }
+
+    // начало строки y: в счетном режиме решения строки не зависят от предыдущих строк
+    void beginRow(int y) {
+        if (mode != RandomMode::Counter) return;
+        rowKey = mixBits64(streamSeed ^ mixBits64(uint64_t(y)));
+        counter = 0;
+        bitsLeft = 0;
+    }
+
+    static void clearBit(uint64_t* row, int x) { row[x >> 6] &= ~(uint64_t(1) << (x & 63)); }
+
+    // объединение множеств ячеек x и x + 1 (множества разные)
+    void join(int x) {
+        int a = right[x]; // следующая за x ячейка ее множества
+        int b = left[x + 1]; // предыдущая перед x + 1 ячейка ее множества
+        right[x] = x + 1; // вставляем список x + 1 сразу после x
+        left[x + 1] = x;
+        right[b] = a; // и замыкаем его на оставшуюся часть списка x
+        left[a] = b;
+    }
+
+    // исключение ячейки из ее множества: в следующей строке она начнет новое множество
+    void detach(int x) {
+        right[left[x]] = right[x];
+        left[right[x]] = left[x];
+        left[x] = right[x] = x;
+    }
+
+    // инициализация первой строки: каждая ячейка - отдельное множество
+    void initializeRow(int width) {
+        left.resize(width); // память выделяется только при росте ширины
+        right.resize(width);
+        for (int x = 0; x < width; ++x) {
+            left[x] = right[x] = x;
         }
     }
     
     // объединение множеств в строке случайным образом
-    void mergeSets(Maze& maze, int row) { 
-        uniform_int_distribution<int> dist(0, 1); // генератор случайных чисел
-        
-        for (int x = 0; x < maze.getWidth() - 1; ++x) { // проходим по всем ячейкам
+    void mergeSets(int width, uint64_t* east) {
+        for (int x = 0; x < width - 1; ++x) { // проходим по всем ячейкам
             // случайное решение об объединении соседних ячеек
-            if (dist(rng) == 1 && maze.getCell(x, row).getSet() != maze.getCell(x + 1, row).getSet()) { // если множества разные
-                // убираем стену между ячейками
-                maze.getCell(x, row).setWall(1, false); // убираем стену влево
-                maze.getCell(x + 1, row).setWall(3, false); // убираем стену вправо
-                
-                // объединяем множества
-                int oldSet = maze.getCell(x + 1, row).getSet(); // сохраняем старое множество
-                int newSet = maze.getCell(x, row).getSet(); // новое множество
-                for (int i = 0; i < maze.getWidth(); ++i) { // проходим по всем ячейкам
-                    if (maze.getCell(i, row).getSet() == oldSet) { // если ячейка имеет старое множество
-                        maze.getCell(i, row).setSet(newSet); // изменяем множество
-                    }
-                }
+            if (randomBit() && right[x] != x + 1) { // если множества разные
+                clearBit(east, x); // убираем стену между ячейками
+                join(x); // объединяем множества
             }
         }
     }
     
     // добавление вертикальных соединений между строками
-    void addVerticalConnections(Maze& maze, int row) {
-        if (row >= maze.getHeight() - 1) return; // если это последняя строка, то ничего не делаем
-        
-        uniform_int_distribution<int> dist(0, 1); // генератор случайных чисел
-        map<int, vector<int>> setMembers; // список ячейк в каждом множестве
-        
-        for (int x = 0; x < maze.getWidth(); ++x) { // проходим по всем ячейкам
-            setMembers[maze.getCell(x, row).getSet()].push_back(x); // добавляем ячейку в список
-        }
-        
-        for (const auto& pair : setMembers) { // проходим по всем множествам
-            const auto& members = pair.second; // список ячейк
-            bool hasConnection = false; // флаг наличия соединения
-            
-            for (int x : members) { // проходим по всем ячейкам
-                if (!hasConnection || dist(rng) == 1) { // если соединения нет или случайное число равно 1
-                    maze.getCell(x, row).setWall(2, false); // убираем верхнюю стену
-                    maze.getCell(x, row + 1).setWall(0, false); // убираем нижнюю стену
-                    maze.getCell(x, row + 1).setSet(maze.getCell(x, row).getSet()); // объединяем множества
-                    hasConnection = true; // устанавливаем флаг
-                }
-            }
-            
-            if (!hasConnection && !members.empty()) { // если соединения нет и список не пуст
-                int x = members[uniform_int_distribution<int>(0, members.size() - 1)(rng)]; // выбираем случайную ячейку
-                maze.getCell(x, row).setWall(2, false); // убираем верхнюю стену
-                maze.getCell(x, row + 1).setWall(0, false); // убираем нижнюю стену
-                maze.getCell(x, row + 1).setSet(maze.getCell(x, row).getSet()); // объединяем множества
+    void addVerticalConnections(int width, uint64_t* south) {
+        for (int x = 0; x < width; ++x) { // проходим по всем ячейкам
+            // самая левая ячейка множества (left[x] >= x) спускается всегда, остальные - случайно,
+            // так у каждого множества остается хотя бы одно соединение вниз
+            if (left[x] >= x || randomBit()) {
+                clearBit(south, x); // убираем стену между строками, множество продолжается
+            } else {
+                detach(x); // ячейка ниже начнет новое множество
             }
         }
     }
     
-    // обработка последней строки лабиринта
-    void processLastRow(Maze& maze) {
-        int lastRow = maze.getHeight() - 1; // индекс последней строки
-        initializeRow(maze, lastRow); // инициализируем последнюю строку
-        
-        // объединяем все различные множества в последней строке
-        for (int x = 0; x < maze.getWidth() - 1; ++x) { // проходим по всем ячейкам
-            if (maze.getCell(x, lastRow).getSet() != maze.getCell(x + 1, lastRow).getSet()) { // если множества разные
-                maze.getCell(x, lastRow).setWall(1, false); // убираем стену влево
-                maze.getCell(x + 1, lastRow).setWall(3, false); // убираем стену вправо
-                
-                int oldSet = maze.getCell(x + 1, lastRow).getSet(); // сохраняем старое множество
-                int newSet = maze.getCell(x, lastRow).getSet(); // новое множество
-                for (int i = 0; i < maze.getWidth(); ++i) { // проходим по всем ячейкам
-                    if (maze.getCell(i, lastRow).getSet() == oldSet) { // если множество равно старому
-                        maze.getCell(i, lastRow).setSet(newSet); // объединяем множества
-                    }
-                }
+    // обработка последней строки лабиринта: объединяем все различные множества
+    void processLastRow(int width, uint64_t* east) {
+        for (int x = 0; x < width - 1; ++x) { // проходим по всем ячейкам
+            if (right[x] != x + 1) { // если множества разные
+                clearBit(east, x); // убираем стену между ячейками
+                join(x); // объединяем множества
             }
         }
     }
 
 public:
-    // конструктор, инициализирует генератор случайных чисел
-    EllerMazeGenerator() : rng(random_device{}()), nextSet(1) {}
+    // конструктор со случайным зерном (зерно сохраняется в лабиринте, генерацию можно повторить)
+    EllerMazeGenerator() : EllerMazeGenerator((uint64_t(random_device{}()) << 32) | random_device{}()) {}
+
+    // конструктор с фиксированным зерном: одинаковые зерно, режим и размер дают побитово один лабиринт
+    explicit EllerMazeGenerator(uint64_t seed, RandomMode mode = RandomMode::Sequential)
+        : seed(seed), streamSeed(seed), mode(mode), rowKey(0), counter(0), bitPool(0), bitsLeft(0) {}
+
+    // зерно следующей генерации; после каждой генерации зерно сменяется на производное от него,
+    // так что серия лабиринтов тоже воспроизводима, а каждый из них повторяется по своему зерну
+    uint64_t getSeed() const { return seed; }
+    void setSeed(uint64_t newSeed) { seed = newSeed; }
+
+    // вид генератора для записи в лабиринт (зависит от режима случайных бит)
+    MazeGeneratorKind getKind() const {
+        return mode == RandomMode::Counter ? MazeGeneratorKind::EllerCounter : MazeGeneratorKind::Eller;
+    }
+
+    RandomMode getRandomMode() const { return mode; }
+    void setRandomMode(RandomMode newMode) { mode = newMode; }
+
+    // построчная генерация в произвольные буферы: rows.east(y)/rows.south(y) дают буферы
+    // строки y (по words слов), rows.commit(y) вызывается, когда строка готова (false - прервать)
+    template <class Rows>
+    bool generateInto(int width, int height, size_t words, Rows& rows) {
+        if (width <= 0 || height <= 0) return true;
+        ProfileScope scope("generate");
+        Profiler::instance().count("cells generated", uint64_t(width) * uint64_t(height));
+
+        initializeRow(width); // инициализируем первую строку
+        beginStream(); // зерно этой генерации - getSeed() до вызова
+
+        // генерируем лабиринт построчно
+        for (int row = 0; row < height; ++row) { // проходим по всем строкам
+            beginRow(row);
+            uint64_t* east = rows.east(row);
+            uint64_t* south = rows.south(row);
+            fill(east, east + words, ~uint64_t(0)); // начинаем со всех стен
+            fill(south, south + words, ~uint64_t(0));
+
+            if (row < height - 1) {
+                mergeSets(width, east); // объединяем множества
+                addVerticalConnections(width, south); // добавляем вертикальные соединения
+            } else {
+                processLastRow(width, east); // обрабатываем последнюю строку
+            }
+            if (!rows.commit(row)) return false;
+        }
+        return true;
+    }
     
-    // основной метод генерации лабиринта
+    // основной метод генерации лабиринта (внешние границы лабиринта закрыты всегда)
     void generate(Maze& maze) override {
-        // генерируем лабиринт построчно
-        for (int row = 0; row < maze.getHeight() - 1; ++row) { // проходим по всем строкам
-            initializeRow(maze, row); // инициализируем строку
-            mergeSets(maze, row); // объединяем множества
-            addVerticalConnections(maze, row); // добавляем вертикальные соединения
+        // строки пишутся прямо в сетку лабиринта
+        struct MazeRows {
+            Maze& maze;
+            uint64_t* east(int y) { return maze.eastWalls(y); }
+            uint64_t* south(int y) { return maze.southWalls(y); }
+            bool commit(int) { return true; }
+        } rows{maze};
+        maze.setSeed(seed); // по этому зерну лабиринт генерируется заново
+        maze.setGenerator(getKind());
+        generateInto(maze.getWidth(), maze.getHeight(), maze.getWordsPerRow(), rows);
+    }
+
+    // потоковая генерация лабиринта width x height: строки по одной отдаются в sink,
+    // в памяти хранится только текущая строка (O(width)). возвращает false, если sink прервал генерацию
+    bool generateRows(int width, int height, IMazeRowSink& sink) {
+        // две строки битов на весь проход (внутри вызова, не на каждую строку)
+        struct StreamRows {
+            IMazeRowSink& sink;
+            size_t words;
+            vector<uint64_t> buffer;
+            uint64_t* east(int) { return buffer.data(); }
+            uint64_t* south(int) { return buffer.data() + words; }
+            bool commit(int y) { return sink.writeRow(y, east(y), south(y), words); }
+        } rows{sink, (size_t(max(width, 0)) + 63) / 64, {}};
+        rows.buffer.resize(rows.words * 2);
+        return generateInto(width, height, rows.words, rows);
+    }
+};
+
+// переиспользуемое рабочее состояние поиска пути: после первого запроса на лабиринте
+// данного размера повторные запросы не выделяют память
+//
+// посещение отмечается номером поколения: ячейка посещена, если mark[c] == epoch,
+// поэтому очистка перед запросом - это O(1) увеличение epoch. остальные массивы
+// действительны только для отмеченных ячеек и не очищаются вовсе.
+class SearchWorkspace {
+public:
+    // элемент очереди с приоритетом (A*)
+    struct HeapEntry {
+        int priority; // оценка f = g + h
+        int cost; // длина пути g (при равной f раньше идет больший g)
+        int cell; // ячейка
+        bool operator<(const HeapEntry& other) const { // для max-кучи std::push_heap: "меньше" = хуже
+            return priority != other.priority ? priority > other.priority : cost < other.cost;
         }
-        processLastRow(maze); // обрабатываем последнюю строку
+    };
 
-        // добавляем внешние границы лабиринта
-        for (int x = 0; x < maze.getWidth(); ++x) { // проходим по всем ячейкам
-            maze.getCell(x, 0).setWall(0, true); // верхняя граница
-            maze.getCell(x, maze.getHeight() - 1).setWall(2, true); // нижняя граница
+    vector<uint32_t> mark; // поколение, в котором ячейка посещена
+    vector<int> prev; // предыдущая ячейка на пути (-1 - начало)
+    vector<int> cost; // длина пути или глубина ячейки
+    vector<uint8_t> flags; // служебный байт на ячейку (волна, закрыта и т. п.)
+    vector<int> frontier; // фронт: очередь, стек или слой
+    vector<int> frontier2; // второй фронт (двунаправленный поиск)
+    vector<int> scratch; // следующий слой
+    vector<HeapEntry> heap; // очередь с приоритетом
+    size_t head = 0; // голова очереди frontier (поиск в ширину)
+    uint32_t epoch = 0; // номер текущего поколения
+
+    // подготовка к новому запросу на лабиринте из cells ячеек
+    void begin(size_t cells) {
+        if (mark.size() < cells) { // память растет только при увеличении лабиринта
+            mark.resize(cells, 0);
+            prev.resize(cells);
+            cost.resize(cells);
+            flags.resize(cells);
         }
-        for (int y = 0; y < maze.getHeight(); ++y) {
-            maze.getCell(0, y).setWall(3, true); // левая граница
-            maze.getCell(maze.getWidth() - 1, y).setWall(1, true); // правая граница
+        if (++epoch == 0) { // счетчик поколений переполнился - единственная полная очистка
+            fill(mark.begin(), mark.end(), 0);
+            epoch = 1;
         }
+        frontier.clear();
+        frontier2.clear();
+        scratch.clear();
+        heap.clear();
+        head = 0;
+    }
+
+    bool isMarked(int cell) const { return mark[cell] == epoch; }
+    void markCell(int cell, int from) {
+        mark[cell] = epoch;
+        prev[cell] = from;
     }
 };
 
+// состояние пошагового поиска пути
+enum class SearchStatus {
+    Running, // поиск продолжается
+    Found, // путь найден
+    NotFound // путь не найден, поиск отменен или лабиринт изменился
+};
+
 // интерфейс для стратегий поиска пути в лабиринте
+//
+// кроме поиска целиком (findPath) поиск можно вести по шагам: beginSearch задает запрос,
+// step(budget) раскрывает не больше budget ячеек и возвращает состояние. между шагами
+// лабиринт должен оставаться неизменным (изменение по версии лабиринта прерывает поиск).
+// алгоритм реализует либо search (поиск целиком, тогда шаг - весь поиск), либо пару
+// startSearch/continueSearch (тогда search по умолчанию - это continueSearch без ограничения).
 class IPathFinder {
 public:
     virtual ~IPathFinder() = default;
-    // чисто виртуальный метод поиска пути
-    virtual vector<pair<int, int>> findPath(const Maze& maze, 
-        int startX, int startY, int endX, int endY) = 0;
+
+    // поиск пути от начальной до конечной точки (пустой вектор - путь не найден)
+    vector<pair<int, int>> findPath(const Maze& maze, 
+        int startX, int startY, int endX, int endY) {
+        vector<pair<int, int>> path;
+        findPath(maze, startX, startY, endX, endY, path);
+        return path;
+    }
+
+    // поиск пути с записью в path: память path и рабочего состояния переиспользуется
+    // между вызовами, поэтому повторные запросы не выделяют память
+    bool findPath(const Maze& maze, int startX, int startY, int endX, int endY,
+        vector<pair<int, int>>& path) {
+        path.clear();
+        nodesExpanded = 0;
+        query = {startX, startY, endX, endY};
+        stepMaze = nullptr; // пошаговый поиск, если шел, прерван (рабочее состояние общее)
+        stepStatus = SearchStatus::NotFound;
+        ProfileScope scope("findPath");
+        bool found = search(maze, startX, startY, endX, endY, path);
+        Profiler::instance().count("nodes expanded", nodesExpanded);
+        return found;
+    }
+
+    // начало пошагового поиска (предыдущий пошаговый поиск отменяется)
+    void beginSearch(const Maze& maze, int startX, int startY, int endX, int endY) {
+        stepPath.clear();
+        nodesExpanded = 0;
+        query = {startX, startY, endX, endY};
+        stepMaze = &maze;
+        stepRevision = maze.getRevision();
+        stepStatus = SearchStatus::Running;
+        startSearch(maze);
+    }
+
+    // следующий шаг: раскрыть не больше budget ячеек (budget > 0)
+    SearchStatus step(size_t budget) {
+        if (stepStatus != SearchStatus::Running) return stepStatus;
+        if (stepMaze->getRevision() != stepRevision) { // лабиринт изменился - продолжать нельзя
+            stepMaze = nullptr;
+            return stepStatus = SearchStatus::NotFound;
+        }
+        ProfileScope scope("search step");
+        size_t expandedBefore = nodesExpanded;
+        stepStatus = continueSearch(*stepMaze, max<size_t>(1, budget), stepPath);
+        Profiler::instance().count("nodes expanded", nodesExpanded - expandedBefore);
+        if (stepStatus != SearchStatus::Running) stepMaze = nullptr;
+        return stepStatus;
+    }
+
+    // отмена пошагового поиска
+    void cancelSearch() {
+        stepMaze = nullptr;
+        stepStatus = SearchStatus::NotFound;
+    }
+
+    SearchStatus getStatus() const { return stepStatus; }
+
+    // путь, найденный пошаговым поиском (пуст, пока поиск не завершен)
+    const vector<pair<int, int>>& getPath() const { return stepPath; }
+
+    // запись раскрываемых ячеек (индексы y * width + x) в trace, nullptr - не записывать
+    void setTrace(vector<int>* cells) { trace = cells; }
+
+    // текущий фронт пошагового поиска (ячейки, ожидающие раскрытия), дописывается в cells
+    virtual void appendFrontier(vector<int>&) const {}
+
+    // название алгоритма (для вывода и выбора)
+    virtual const char* getName() const = 0;
+
+    // новый экземпляр того же алгоритма со своим рабочим состоянием (для параллельных запросов);
+    // общие неизменяемые данные (например, индекс) копия может разделять с оригиналом
+    virtual unique_ptr<IPathFinder> clone() const = 0;
+
+    // подготовка к запросам по лабиринту (например, построение индекса); вызывается
+    // до параллельных запросов, чтобы сами запросы только читали общие данные
+    virtual void prepare(const Maze&) {}
+
+    // число ячеек, раскрытых последним поиском (целиком или по шагам)
+    size_t getNodesExpanded() const { return nodesExpanded; }
 
 protected:
+    // текущий запрос
+    struct Query {
+        int startX, startY, endX, endY;
+    };
+
+    size_t nodesExpanded = 0; // счетчик раскрытых ячеек текущего поиска
+    SearchWorkspace workspace; // рабочее состояние, переиспользуемое между запросами
+    Query query = {0, 0, 0, 0}; // запрос текущего поиска
+    vector<int>* trace = nullptr; // запись раскрытых ячеек (для отображения хода поиска)
+
+    // поиск пути целиком: path пуст при вызове (по умолчанию - continueSearch без ограничения)
+    virtual bool search(const Maze& maze, int, int, int, int, vector<pair<int, int>>& path) {
+        startSearch(maze);
+        return continueSearch(maze, SIZE_MAX, path) == SearchStatus::Found;
+    }
+
+    // подготовка рабочего состояния к запросу query
+    virtual void startSearch(const Maze&) {}
+
+    // продолжение поиска: не больше budget раскрытий, путь дописывается в path при успехе
+    // (по умолчанию - поиск целиком за один шаг)
+    virtual SearchStatus continueSearch(const Maze& maze, size_t, vector<pair<int, int>>& path) {
+        bool found = search(maze, query.startX, query.startY, query.endX, query.endY, path);
+        return found ? SearchStatus::Found : SearchStatus::NotFound;
+    }
+
+    // учет раскрытия ячейки
+    void expand(int cell) {
+        ++nodesExpanded;
+        if (trace) trace->push_back(cell);
+    }
+
+    // восстановление пути до end по массиву предыдущих ячеек рабочего состояния (дописывается в path)
+    void appendPathTo(int width, int end, vector<pair<int, int>>& path) const {
+        size_t from = path.size();
+        for (int cell = end; cell != -1; cell = workspace.prev[cell]) {
+            path.push_back({cell % width, cell / width});
+        }
+        reverse(path.begin() + from, path.end()); // от начальной точки к конечной
+    }
+
     // вспомогательный метод для проверки возможности перемещения между ячейками
     bool isValidMove(const Maze& maze, int fromX, int fromY, int toX, int toY) const { 
         if (!maze.isValidCell(toX, toY)) return false; // проверяем валидность координат
         
-        int dx = toX - fromX; // расстояние по x
-        int dy = toY - fromY; // расстояние по y
-        
-        // определяем индекс стены в зависимости от направления движения
-        int wallIndex; // индекс стены
-        if (dx == 1) wallIndex = 1; // движение вправо
-        else if (dx == -1) wallIndex = 3; // движение влево
-        else if (dy == 1) wallIndex = 2; // движение вниз
-        else wallIndex = 0; // движение вверх
-        
-        return !maze.getCell(fromX, fromY).hasWall(wallIndex); // проверяем наличие стены в указанном направлении
+        int wallIndex = Directions::between(toX - fromX, toY - fromY); // индекс стены по направлению движения
+        return !maze.hasWall(fromX, fromY, wallIndex); // проверяем наличие стены в указанном направлении
+    }
+
+private:
+    const Maze* stepMaze = nullptr; // лабиринт пошагового поиска
+    uint64_t stepRevision = 0; // его версия в начале поиска
+    SearchStatus stepStatus = SearchStatus::NotFound; // состояние пошагового поиска
+    vector<pair<int, int>> stepPath; // путь пошагового поиска
+};
+
+// конвейер поиска: раскладка сетки, соседи и стратегия - параметры шаблона
+//
+// PathSearch<Grid, Neighbors, Strategy> - общий цикл поиска с возвратом, в ширину и A*:
+// сетка (Grid) дает битовые ряды строк, политика соседей (Neighbors) перечисляет соседние клетки,
+// стратегия (Strategy) задает фронт в рабочем состоянии (очередь, стек, куча). все три
+// подставляются при компиляции, поэтому внутренний цикл не содержит виртуальных вызовов и
+// проверок координат. у FixedGrid<W, H> размеры - константы, и деление на ширину сворачивается.
+// к IPathFinder конвейер подключает PolicyPathFinder, на нем построены классы ниже.
+
+// сетка произвольного размера (размеры известны только во время работы)
+class DynamicGrid {
+private:
+    const uint64_t* base; // битовые ряды первой строки
+    int width, height;
+    size_t words; // слов на битовый ряд
+
+public:
+    static bool accepts(const Maze&) { return true; }
+
+    explicit DynamicGrid(const Maze& maze)
+        : base(maze.getHeight() > 0 ? maze.eastWalls(0) : nullptr), width(maze.getWidth()),
+          height(maze.getHeight()), words(maze.getWordsPerRow()) {}
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    const uint64_t* eastWalls(int y) const { return base + size_t(y) * 2 * words; }
+    const uint64_t* southWalls(int y) const { return eastWalls(y) + words; }
+};
+
+// сетка размера W x H, известного при компиляции (небольшие лабиринты)
+template <int W, int H>
+class FixedGrid {
+    static_assert(W > 0 && H > 0 && W * H <= 4096, "FixedGrid is meant for small mazes");
+
+private:
+    const uint64_t* base; // битовые ряды первой строки
+
+public:
+    static constexpr size_t WORDS = (size_t(W) + 63) / 64; // слов на битовый ряд
+
+    static bool accepts(const Maze& maze) { return maze.getWidth() == W && maze.getHeight() == H; }
+
+    explicit FixedGrid(const Maze& maze) : base(maze.eastWalls(0)) {} // maze должен подходить (accepts)
+
+    static constexpr int getWidth() { return W; }
+    static constexpr int getHeight() { return H; }
+    const uint64_t* eastWalls(int y) const { return base + size_t(y) * 2 * WORDS; }
+    const uint64_t* southWalls(int y) const { return eastWalls(y) + WORDS; }
+};
+
+// соседи через открытые проходы в порядке вверх, вправо, вниз, влево (как Maze::forEachOpenNeighbor);
+// visit(next, x, y) получает индекс соседа и его координаты
+struct OpenNeighbors {
+    template <class Grid, class Visitor>
+    static void forEach(const Grid& grid, int cell, Visitor&& visit) {
+        int width = grid.getWidth();
+        int x = cell % width, y = cell / width;
+        if (y > 0 && !Maze::testBit(grid.southWalls(y - 1), x)) visit(cell - width, x, y - 1);
+        if (!Maze::testBit(grid.eastWalls(y), x)) visit(cell + 1, x + 1, y); // у последнего столбца правая стена есть всегда
+        if (!Maze::testBit(grid.southWalls(y), x)) visit(cell + width, x, y + 1); // у последней строки нижняя стена есть всегда
+        if (x > 0 && !Maze::testBit(grid.eastWalls(y), x - 1)) visit(cell - 1, x - 1, y);
+    }
+};
+
+// стратегия поиска в ширину: очередь workspace.frontier с головой workspace.head, кратчайший путь
+struct BreadthFirst {
+    static constexpr bool USES_COST = false; // ячейка посещается один раз, длины пути не хранятся
+
+    static bool empty(const SearchWorkspace& workspace) { return workspace.head == workspace.frontier.size(); }
+    static void push(SearchWorkspace& workspace, int cell, int, int) { workspace.frontier.push_back(cell); }
+    static int pop(SearchWorkspace& workspace) { return workspace.frontier[workspace.head++]; }
+
+    static void appendFrontier(const SearchWorkspace& workspace, vector<int>& cells) {
+        cells.insert(cells.end(), workspace.frontier.begin() + min(workspace.head, workspace.frontier.size()),
+            workspace.frontier.end());
+    }
+};
+
+// стратегия поиска в глубину: стек workspace.frontier, путь не обязательно кратчайший
+struct DepthFirst {
+    static constexpr bool USES_COST = false;
+
+    static bool empty(const SearchWorkspace& workspace) { return workspace.frontier.empty(); }
+    static void push(SearchWorkspace& workspace, int cell, int, int) { workspace.frontier.push_back(cell); }
+    static int pop(SearchWorkspace& workspace) {
+        int cell = workspace.frontier.back();
+        workspace.frontier.pop_back();
+        return cell;
+    }
+
+    static void appendFrontier(const SearchWorkspace& workspace, vector<int>& cells) {
+        cells.insert(cells.end(), workspace.frontier.begin(), workspace.frontier.end());
+    }
+};
+
+// стратегия A* с манхэттенской эвристикой: куча workspace.heap по f = g + h. при более коротком
+// пути до открытой ячейки в кучу кладется новая запись, старая остается и пропускается при
+// извлечении; раскрытая ячейка закрывается (workspace.flags) и больше не раскрывается -
+// с согласованной эвристикой ее длина пути к этому моменту уже наименьшая
+struct BestFirst {
+    static constexpr bool USES_COST = true;
+
+    static bool empty(const SearchWorkspace& workspace) { return workspace.heap.empty(); }
+    static void push(SearchWorkspace& workspace, int cell, int cost, int estimate) {
+        workspace.heap.push_back({cost + estimate, cost, cell});
+        push_heap(workspace.heap.begin(), workspace.heap.end());
+    }
+    static int pop(SearchWorkspace& workspace) {
+        pop_heap(workspace.heap.begin(), workspace.heap.end());
+        int cell = workspace.heap.back().cell;
+        workspace.heap.pop_back();
+        return cell;
+    }
+
+    static void appendFrontier(const SearchWorkspace& workspace, vector<int>& cells) {
+        for (const auto& entry : workspace.heap) {
+            if (!workspace.flags[entry.cell]) cells.push_back(entry.cell); // устаревшие записи пропускаем
+        }
+    }
+};
+
+// поиск пути по сетке Grid с соседями Neighbors и стратегией Strategy в рабочем состоянии
+// workspace: объект легкий и создается на каждый шаг, состояние между шагами - в workspace
+template <class Grid, class Neighbors, class Strategy>
+class PathSearch {
+private:
+    const Grid& grid;
+    SearchWorkspace& workspace;
+    int endX, endY, end; // конечная точка
+
+    int estimate(int x, int y) const { return abs(x - endX) + abs(y - endY); }
+
+public:
+    PathSearch(const Grid& grid, SearchWorkspace& workspace, int endX, int endY)
+        : grid(grid), workspace(workspace), endX(endX), endY(endY), end(endY * grid.getWidth() + endX) {}
+
+    // начало поиска от (startX, startY): по умолчанию все ячейки не посещены
+    void start(int startX, int startY) {
+        workspace.begin(size_t(grid.getWidth()) * grid.getHeight());
+        int start = startY * grid.getWidth() + startX;
+        workspace.markCell(start, -1);
+        if constexpr (Strategy::USES_COST) {
+            workspace.cost[start] = 0;
+            workspace.flags[start] = 0;
+        }
+        Strategy::push(workspace, start, 0, Strategy::USES_COST ? estimate(startX, startY) : 0);
+    }
+
+    // не больше budget раскрытий; onExpand(cell) вызывается на каждое раскрытие. при Found
+    // путь до конечной точки восстанавливается по workspace.prev
+    template <class OnExpand>
+    SearchStatus run(size_t budget, OnExpand&& onExpand) {
+        vector<int>& cost = workspace.cost; // длина лучшего найденного пути (только при USES_COST)
+        vector<uint8_t>& closed = workspace.flags; // 1 - ячейка раскрыта (только при USES_COST)
+        while (!Strategy::empty(workspace)) {
+            if (budget == 0) return SearchStatus::Running; // продолжим на следующем шаге
+            int current = Strategy::pop(workspace);
+            if constexpr (Strategy::USES_COST) {
+                if (closed[current]) continue; // устаревшая запись
+                closed[current] = 1;
+            }
+            --budget;
+            onExpand(current);
+            if (current == end) return SearchStatus::Found;
+
+            Neighbors::forEach(grid, current, [&](int next, int x, int y) {
+                bool seen = workspace.isMarked(next);
+                if constexpr (Strategy::USES_COST) {
+                    int nextCost = cost[current] + 1;
+                    if (seen && (closed[next] || nextCost >= cost[next])) return;
+                    workspace.markCell(next, current);
+                    cost[next] = nextCost;
+                    closed[next] = 0;
+                    Strategy::push(workspace, next, nextCost, estimate(x, y));
+                } else {
+                    (void)x, (void)y;
+                    if (seen) return;
+                    workspace.markCell(next, current); // запоминаем предыдущую ячейку
+                    Strategy::push(workspace, next, 0, 0);
+                }
+            });
+        }
+        return SearchStatus::NotFound; // путь не найден
+    }
+};
+
+// IPathFinder поверх конвейера: квадратный лабиринт со стороной из Sizes ищется по FixedGrid,
+// остальные - по DynamicGrid. поиск идет по шагам в общем рабочем состоянии
+template <class Strategy, class Neighbors, int... Sizes>
+class PolicyPathFinder : public IPathFinder {
+public:
+    void appendFrontier(vector<int>& cells) const override { Strategy::appendFrontier(workspace, cells); }
+
+protected:
+    void startSearch(const Maze& maze) override {
+        withGrid(maze, [&](const auto& grid) { makeSearch(grid).start(query.startX, query.startY); });
+    }
+
+    SearchStatus continueSearch(const Maze& maze, size_t budget, vector<pair<int, int>>& path) override {
+        SearchStatus status = SearchStatus::NotFound;
+        withGrid(maze, [&](const auto& grid) { status = makeSearch(grid).run(budget, [this](int cell) { expand(cell); }); });
+        if (status == SearchStatus::Found) appendPathTo(maze.getWidth(), query.endY * maze.getWidth() + query.endX, path);
+        return status;
+    }
+
+private:
+    template <class Grid>
+    PathSearch<Grid, Neighbors, Strategy> makeSearch(const Grid& grid) {
+        return PathSearch<Grid, Neighbors, Strategy>(grid, workspace, query.endX, query.endY);
+    }
+
+    // вызов visit с сеткой лабиринта: FixedGrid подходящего размера или DynamicGrid
+    template <class Visit>
+    static void withGrid(const Maze& maze, Visit&& visit) {
+        bool fixed = ((FixedGrid<Sizes, Sizes>::accepts(maze) && (visit(FixedGrid<Sizes, Sizes>(maze)), true)) || ...);
+        if (!fixed) visit(DynamicGrid(maze));
     }
 };
 
+// конвейер для размеров из меню приложения (5x5 .. 50x50): они ищутся по FixedGrid
+template <class Strategy>
+using MenuPathFinder = PolicyPathFinder<Strategy, OpenNeighbors, 5, 10, 20, 30, 40, 50>;
+
 // конкретная реализация поиска пути методом поиска в глубину с возвратом
-class BacktrackingPathFinder : public IPathFinder {
+class BacktrackingPathFinder : public MenuPathFinder<DepthFirst> {
 public:
-    // метод поиска пути от начальной до конечной точки
-    vector<pair<int, int>> findPath(const Maze& maze, 
-        int startX, int startY, int endX, int endY) override { 
-        
-        vector<pair<int, int>> path; // путь
+    const char* getName() const override { return "backtracking"; }
+    unique_ptr<IPathFinder> clone() const override { return unique_ptr<IPathFinder>(new BacktrackingPathFinder()); }
+};
 
-        // матрица для отслеживания посещенных ячеек
-        vector<vector<bool>> visited(maze.getHeight(), 
-            vector<bool>(maze.getWidth(), false)); // по умолчанию все ячейки не посещены
-        
-        // стек для хранения пути
-        stack<pair<int, int>> stack;
-        stack.push({startX, startY}); // начальная точка
-        visited[startY][startX] = true; // помечаем ячейку как посещенную
-        
-        // матрица для хранения предыдущих ячеек для восстановления пути
-        vector<vector<pair<int, int>>> prev(maze.getHeight(), 
-            vector<pair<int, int>>(maze.getWidth(), {-1, -1})); // предыдущая ячейка по умолчанию не найдена
-        
-        bool found = false; // флаг нахождения пути
-        
-        // поиск пути в глубину
-        while (!stack.empty() && !found) { // пока стек не пуст и путь не найден
-            auto current = stack.top(); // текущая ячейка
-            stack.pop(); // удаляем ячейку из стека
-            
-            // если достигли конечной точки
-            if (current.first == endX && current.second == endY) {
-                found = true; // флаг нахождения пути
-                break;
+// поиск в ширину: кратчайший путь в лабиринте с циклами
+class BfsPathFinder : public MenuPathFinder<BreadthFirst> {
+public:
+    const char* getName() const override { return "bfs"; }
+    unique_ptr<IPathFinder> clone() const override { return unique_ptr<IPathFinder>(new BfsPathFinder()); }
+};
+
+// поиск A* с манхэттенской эвристикой: раскрывает ячейки в сторону цели
+class AStarPathFinder : public MenuPathFinder<BestFirst> {
+public:
+    const char* getName() const override { return "astar"; }
+    unique_ptr<IPathFinder> clone() const override { return unique_ptr<IPathFinder>(new AStarPathFinder()); }
+};
+
+// двунаправленный поиск в ширину: волны от начала и от конца растут навстречу,
+// на каждом шаге раскрывается целый слой меньшей волны
+class BidirectionalBfsPathFinder : public IPathFinder {
+private:
+    // состояние текущего слоя (поиск по шагам может прерваться посреди слоя)
+    bool inLayer = false; // слой начат
+    int from = 1; // растущая волна: 1 - начала, 2 - конца
+    size_t position = 0; // следующая ячейка слоя
+    int bestLength = INT_MAX; // лучшая встреча в этом слое
+    int meetA = -1, meetB = -1;
+
+public:
+    const char* getName() const override { return "bibfs"; }
+    unique_ptr<IPathFinder> clone() const override { return unique_ptr<IPathFinder>(new BidirectionalBfsPathFinder()); }
+
+    void appendFrontier(vector<int>& cells) const override {
+        cells.insert(cells.end(), workspace.frontier.begin(), workspace.frontier.end());
+        cells.insert(cells.end(), workspace.frontier2.begin(), workspace.frontier2.end());
+        if (inLayer) cells.insert(cells.end(), workspace.scratch.begin(), workspace.scratch.end());
+    }
+
+protected:
+    void startSearch(const Maze& maze) override {
+        int width = maze.getWidth();
+        workspace.begin(size_t(width) * maze.getHeight());
+        inLayer = false;
+        int start = query.startY * width + query.startX;
+        int end = query.endY * width + query.endX;
+        if (start == end) return;
+        workspace.markCell(start, -1);
+        workspace.markCell(end, -1);
+        workspace.cost[start] = workspace.cost[end] = 0;
+        workspace.flags[start] = 1;
+        workspace.flags[end] = 2;
+        workspace.frontier.push_back(start);
+        workspace.frontier2.push_back(end);
+    }
+
+    SearchStatus continueSearch(const Maze& maze, size_t budget, vector<pair<int, int>>& path) override {
+        int width = maze.getWidth();
+        vector<int>& depth = workspace.cost; // расстояние от источника своей волны
+        vector<uint8_t>& side = workspace.flags; // 1 - волна начала, 2 - волна конца
+        vector<int>* layers[3] = {nullptr, &workspace.frontier, &workspace.frontier2}; // текущие слои волн
+        vector<int>& next = workspace.scratch;
+
+        int start = query.startY * width + query.startX;
+        int end = query.endY * width + query.endX;
+        if (start == end) {
+            expand(start);
+            path.push_back({query.startX, query.startY});
+            return SearchStatus::Found;
+        }
+
+        for (;;) {
+            if (!inLayer) { // новый слой
+                if (layers[1]->empty() || layers[2]->empty()) return SearchStatus::NotFound; // путь не найден
+                from = layers[1]->size() <= layers[2]->size() ? 1 : 2; // растим меньшую волну
+                bestLength = INT_MAX;
+                meetA = meetB = -1;
+                position = 0;
+                next.clear();
+                inLayer = true;
+            }
+            const vector<int>& layer = *layers[from];
+            for (; position < layer.size(); ++position) {
+                if (budget-- == 0) return SearchStatus::Running;
+                int current = layer[position];
+                expand(current);
+                maze.forEachOpenNeighbor(current % width, current / width, [&](int x, int y) {
+                    int cell = y * width + x;
+                    if (!workspace.isMarked(cell)) {
+                        workspace.markCell(cell, current);
+                        side[cell] = uint8_t(from);
+                        depth[cell] = depth[current] + 1;
+                        next.push_back(cell);
+                    } else if (side[cell] != from && depth[current] + depth[cell] + 1 < bestLength) {
+                        bestLength = depth[current] + depth[cell] + 1; // волны встретились
+                        meetA = current;
+                        meetB = cell;
+                    }
+                });
             }
-            
-            // проверяем все соседние ячейки
-            auto neighbors = maze.getNeighbors(current.first, current.second); // список соседних ячейк
-            
-            for (const auto& neighbor : neighbors) { // проходим по всем соседям
-                if (!visited[neighbor.second][neighbor.first] && // если ячейка не посещена
-                    isValidMove(maze, current.first, current.second, // и можно переместит
-                              neighbor.first, neighbor.second)) { // в эту ячейку
-                    stack.push(neighbor); // добавляем ячейку в стек
-                    visited[neighbor.second][neighbor.first] = true; // помечаем ячейку как посещенную
-                    prev[neighbor.second][neighbor.first] = current; // запоминаем предыдущую ячейку
+            inLayer = false;
+            if (meetA != -1) {
+                if (from == 2) swap(meetA, meetB); // meetA - в волне начала, meetB - в волне конца
+                appendPathTo(width, meetA, path); // начало .. meetA
+                for (int cell = meetB; cell != -1; cell = workspace.prev[cell]) { // meetB .. конец
+                    path.push_back({cell % width, cell / width});
                 }
+                return SearchStatus::Found;
             }
+            layers[from]->swap(next);
         }
-        
-        // восстанавливаем путь, если он найден
-        if (found) {
-            auto current = make_pair(endX, endY); // текущая ячейка
-            while (current.first != -1 && current.second != -1) { // пока не достигли начальной ячейки
-                path.push_back(current); // добавляем ячейку в путь
-                current = prev[current.second][current.first]; // переходим к предыдущей ячейке
+    }
+};
+
+// индекс лабиринта-дерева для запросов расстояния и пути без поиска
+//
+// лабиринт Эллера - остовное дерево клеток, поэтому путь между двумя клетками единственен
+// и проходит через их наименьшего общего предка (LCA). индекс один раз обходит дерево от
+// клетки (0, 0) и хранит для каждой клетки направление к родителю, глубину, номер компоненты
+// и номер в прямом обходе (эйлеров обход без возвратов). несвязный лабиринт дает лес: каждая
+// еще не обойденная клетка становится корнем нового дерева со своей компонентой.
+// LCA(u, v) при tin[u] < tin[v] - это клетка, чей номер минимален среди номеров родителей
+// клеток с номерами (tin[u], tin[v]]; минимум ищется разреженной таблицей по блокам из 32
+// номеров и просмотром краев. запрос расстояния - O(1) (не больше ~70 сравнений), путь -
+// O(длины пути).
+// для лабиринта с циклами индекс строит остовное дерево обхода, и пути по нему не кратчайшие.
+class MazeTreeIndex {
+private:
+    static constexpr int BLOCK = 32; // размер блока минимумов
+    static constexpr uint8_t ROOT = 4; // направление "нет родителя"
+
+    const Maze* builtMaze = nullptr; // для какого лабиринта построен индекс
+    uint64_t builtRevision = 0; // и какой его версии
+    int width = 0;
+    vector<uint8_t> parentDir; // направление к родителю: 0-вверх, 1-вправо, 2-вниз, 3-влево
+    vector<int> depth; // глубина клетки в дереве
+    vector<int> tin; // номер клетки в прямом обходе
+    vector<int> component; // номер дерева (компоненты связности) клетки
+    vector<int> order; // клетка по номеру обхода
+    vector<int> parentTin; // номер родителя для клетки order[i]
+    vector<vector<int>> sparse; // sparse[k][b] - минимум parentTin по блокам b .. b + 2^k - 1
+
+    int parentOf(int cell) const {
+        int dir = parentDir[cell];
+        return (cell / width + Directions::dy[dir]) * width + cell % width + Directions::dx[dir];
+    }
+
+    // минимум parentTin на отрезке номеров [from, to]
+    int rangeMin(int from, int to) const {
+        int result = INT_MAX;
+        int firstBlock = from / BLOCK + 1, lastBlock = to / BLOCK - 1; // блоки целиком внутри отрезка
+        if (firstBlock > lastBlock) { // короткий отрезок - просто просматриваем
+            for (int i = from; i <= to; ++i) result = min(result, parentTin[i]);
+            return result;
+        }
+        for (int i = from; i < firstBlock * BLOCK; ++i) result = min(result, parentTin[i]);
+        for (int i = (lastBlock + 1) * BLOCK; i <= to; ++i) result = min(result, parentTin[i]);
+        int level = 0;
+        while ((2 << level) <= lastBlock - firstBlock + 1) ++level;
+        return min(result, min(sparse[level][firstBlock], sparse[level][lastBlock - (1 << level) + 1]));
+    }
+
+public:
+    // построение индекса (O(n) памяти и времени, память переиспользуется при перестроении)
+    void build(const Maze& maze) {
+        width = maze.getWidth();
+        size_t cells = size_t(width) * maze.getHeight();
+        parentDir.assign(cells, ROOT);
+        depth.resize(cells);
+        tin.assign(cells, -1);
+        component.resize(cells);
+        order.clear();
+        parentTin.clear();
+
+        // прямой обход из каждой еще не обойденной клетки: явный стек, поддеревья и деревья
+        // получают подряд идущие номера
+        vector<int> stack;
+        int components = 0;
+        for (size_t root = 0; root < cells; ++root) {
+            if (tin[root] != -1) continue;
+            stack.push_back(int(root));
+            depth[root] = 0;
+            while (!stack.empty()) {
+                int cell = stack.back();
+                stack.pop_back();
+                if (tin[cell] != -1) continue; // уже достигнута другим путем (лабиринт с циклами)
+                tin[cell] = int(order.size());
+                component[cell] = components;
+                order.push_back(cell);
+                parentTin.push_back(parentDir[cell] == ROOT ? -1 : tin[parentOf(cell)]);
+                int x = cell % width, y = cell / width;
+                for (int dir = 0; dir < 4; ++dir) {
+                    if (maze.hasWall(x, y, dir)) continue;
+                    int child = (y + Directions::dy[dir]) * width + x + Directions::dx[dir];
+                    if (tin[child] != -1) continue;
+                    parentDir[child] = uint8_t(Directions::opposite(dir)); // направление обратно к родителю
+                    depth[child] = depth[cell] + 1;
+                    stack.push_back(child);
+                }
             }
-            reverse(path.begin(), path.end()); // переворачиваем путь
+            ++components;
         }
-        
-        return path; // возвращаем путь
+
+        // разреженная таблица минимумов по блокам
+        int blocks = (int(order.size()) + BLOCK - 1) / BLOCK;
+        sparse.assign(1, vector<int>(blocks, INT_MAX));
+        for (int i = 0; i < int(order.size()); ++i) sparse[0][i / BLOCK] = min(sparse[0][i / BLOCK], parentTin[i]);
+        for (int k = 1; (1 << k) <= blocks; ++k) {
+            sparse.emplace_back(blocks - (1 << k) + 1);
+            for (int b = 0; b + (1 << k) <= blocks; ++b) {
+                sparse[k][b] = min(sparse[k - 1][b], sparse[k - 1][b + (1 << (k - 1))]);
+            }
+        }
+
+        builtMaze = &maze;
+        builtRevision = maze.getRevision();
     }
 
-    // метод отрисовки найденного пути
-    void drawPath(sf::RenderWindow& window, float cellSize, 
-        const vector<pair<int, int>>& path) { 
-        if (path.empty()) return; // если путь пуст
-        
-        // отрисовка линии пути
-        for (size_t i = 1; i < path.size() - 1; ++i) { // проходим по всем ячейкам
-            sf::RectangleShape line(sf::Vector2f(cellSize / 4, cellSize / 4)); // квадрат
-            line.setPosition(path[i].first * cellSize + cellSize / 2 - cellSize / 8, // позиция
-                           path[i].second * cellSize + cellSize / 2 - cellSize / 8);
-            line.setFillColor(sf::Color::Green); // цвет
-            window.draw(line); // отрисовка
+    // индекс построен для этого лабиринта и он с тех пор не менялся
+    bool isValidFor(const Maze& maze) const {
+        return builtMaze == &maze && builtRevision == maze.getRevision();
+    }
+
+    // наименьший общий предок клеток a и b (индексы y * width + x); -1 - клетки в разных компонентах
+    int lowestCommonAncestor(int a, int b) const {
+        if (component[a] != component[b]) return -1; // номера деревьев идут подряд, LCA только внутри одного
+        if (a == b) return a;
+        int ta = tin[a], tb = tin[b];
+        if (ta > tb) swap(ta, tb);
+        return order[rangeMin(ta + 1, tb)];
+    }
+
+    // длина пути между клетками в переходах (-1 - путь не существует)
+    int distance(int startX, int startY, int endX, int endY) const {
+        int a = startY * width + startX, b = endY * width + endX;
+        int lca = lowestCommonAncestor(a, b);
+        return lca == -1 ? -1 : depth[a] + depth[b] - 2 * depth[lca];
+    }
+
+    // путь между клетками в path (дописывается), false - путь не существует
+    bool path(int startX, int startY, int endX, int endY, vector<pair<int, int>>& path) const {
+        int a = startY * width + startX, b = endY * width + endX;
+        int lca = lowestCommonAncestor(a, b);
+        if (lca == -1) return false;
+        for (int cell = a; cell != lca; cell = parentOf(cell)) path.push_back({cell % width, cell / width});
+        path.push_back({lca % width, lca / width});
+        size_t middle = path.size();
+        for (int cell = b; cell != lca; cell = parentOf(cell)) path.push_back({cell % width, cell / width});
+        reverse(path.begin() + middle, path.end()); // вторая половина идет от lca к концу
+        return true;
+    }
+};
+
+// поиск пути по индексу дерева: индекс строится при первом запросе и автоматически
+// перестраивается, когда лабиринт меняется (по версии лабиринта)
+class TreePathFinder : public IPathFinder {
+private:
+    shared_ptr<MazeTreeIndex> index = make_shared<MazeTreeIndex>();
+
+public:
+    const char* getName() const override { return "tree"; }
+
+    // копия разделяет индекс с оригиналом
+    unique_ptr<IPathFinder> clone() const override {
+        unique_ptr<TreePathFinder> copy(new TreePathFinder());
+        copy->index = index;
+        return copy;
+    }
+
+    void prepare(const Maze& maze) override { getIndex(maze); }
+
+    const MazeTreeIndex& getIndex(const Maze& maze) {
+        if (!index->isValidFor(maze)) index->build(maze);
+        return *index;
+    }
+
+protected:
+    bool search(const Maze& maze, int startX, int startY, int endX, int endY,
+        vector<pair<int, int>>& path) override {
+        bool found = getIndex(maze).path(startX, startY, endX, endY, path);
+        nodesExpanded = path.size(); // проходим только клетки самого пути
+        return found;
+    }
+};
+
+// поле расстояний от одной клетки: поиск в ширину от источника хранит для размеченных
+// клеток расстояние и направление к предшественнику
+//
+// поиск в ширину размечает клетку сразу окончательным расстоянием, поэтому поле строится
+// лениво: запрос к размеченной клетке - проход по предшественникам (O(длины пути)), иначе
+// поиск продолжается с сохраненной очереди до нужной клетки. поле действительно, пока не
+// сменились источник или версия лабиринта.
+class DistanceField {
+private:
+    static constexpr uint8_t SOURCE = 4; // направление "нет предшественника"
+
+    const Maze* builtMaze = nullptr; // для какого лабиринта строится поле
+    uint64_t builtRevision = 0; // и какой его версии
+    int width = 0, height = 0;
+    int source = -1; // клетка-источник
+    vector<int> distances; // расстояние от источника (-1 - клетка еще не размечена)
+    vector<uint8_t> parentDir; // направление к предшественнику (номер в Directions)
+    vector<int> queue; // очередь поиска (все размеченные клетки в порядке разметки)
+    size_t head = 0; // голова очереди
+    int maxDistance = 0; // наибольшее расстояние среди размеченных
+
+public:
+    // поле построено (или строится) от (x, y) по текущей версии maze
+    bool isValidFor(const Maze& maze, int x, int y) const {
+        return builtMaze == &maze && builtRevision == maze.getRevision() && source == y * width + x;
+    }
+
+    // начало поля от (x, y): размечен только источник (O(n) на очистку, память переиспользуется)
+    void reset(const Maze& maze, int x, int y) {
+        builtMaze = &maze;
+        builtRevision = maze.getRevision();
+        width = maze.getWidth();
+        height = maze.getHeight();
+        source = y * width + x;
+        distances.assign(size_t(width) * height, -1);
+        parentDir.resize(size_t(width) * height);
+        queue.clear();
+        head = 0;
+        maxDistance = 0;
+        distances[source] = 0;
+        parentDir[source] = SOURCE;
+        queue.push_back(source);
+    }
+
+    // продолжение поиска: не больше budget раскрытий или до разметки клетки target (-1 - до конца);
+    // раскрытые клетки дописываются в trace (если задан), возвращает число раскрытий
+    size_t extend(size_t budget, int target = -1, vector<int>* trace = nullptr) {
+        const Maze& maze = *builtMaze;
+        size_t expanded = 0;
+        while (head < queue.size() && expanded < budget && (target < 0 || distances[target] < 0)) {
+            int current = queue[head++];
+            ++expanded;
+            if (trace) trace->push_back(current);
+            int nextDistance = distances[current] + 1;
+            int x = current % width, y = current / width;
+            maze.forEachOpenNeighbor(x, y, [&](int nx, int ny) {
+                int next = ny * width + nx;
+                if (distances[next] >= 0) return;
+                distances[next] = nextDistance;
+                parentDir[next] = uint8_t(Directions::between(x - nx, y - ny)); // от соседа обратно к current
+                maxDistance = nextDistance;
+                queue.push_back(next);
+            });
         }
+        return expanded;
+    }
+
+    // поиск закончен: размечены все достижимые клетки
+    bool isComplete() const { return builtMaze && head >= queue.size(); }
+
+    // расстояние от источника до (x, y), -1 - не размечена (недостижима или поиск не дошел)
+    int distance(int x, int y) const { return distances[size_t(y) * width + x]; }
+
+    // наибольшее расстояние среди размеченных клеток
+    int getMaxDistance() const { return maxDistance; }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getSource() const { return source; }
+    uint64_t getRevision() const { return builtRevision; } // версия лабиринта, по которой строится поле
+
+    // клетки очереди, ожидающие раскрытия (фронт), дописываются в cells
+    void appendFrontier(vector<int>& cells) const { cells.insert(cells.end(), queue.begin() + head, queue.end()); }
+
+    // путь от источника до размеченной клетки (x, y) дописывается в path
+    bool path(int x, int y, vector<pair<int, int>>& path) const {
+        if (distance(x, y) < 0) return false;
+        size_t from = path.size();
+        for (;;) {
+            path.push_back({x, y});
+            uint8_t dir = parentDir[size_t(y) * width + x];
+            if (dir == SOURCE) break;
+            x += Directions::dx[dir];
+            y += Directions::dy[dir];
+        }
+        reverse(path.begin() + from, path.end()); // от источника к клетке
+        return true;
+    }
+};
+
+// поиск по полю расстояний от начальной точки: поле переиспользуется, пока не сменятся
+// начальная точка или лабиринт, поэтому запросы с тем же началом и новым концом - проход по полю
+class DistanceFieldPathFinder : public IPathFinder {
+private:
+    DistanceField field;
+
+public:
+    const char* getName() const override { return "field"; }
+    unique_ptr<IPathFinder> clone() const override { return unique_ptr<IPathFinder>(new DistanceFieldPathFinder()); }
+
+    void appendFrontier(vector<int>& cells) const override { field.appendFrontier(cells); }
+
+    // поле последнего запроса (для тепловой карты)
+    DistanceField& getField() { return field; }
+
+protected:
+    void startSearch(const Maze& maze) override {
+        if (!field.isValidFor(maze, query.startX, query.startY)) field.reset(maze, query.startX, query.startY);
+    }
+
+    SearchStatus continueSearch(const Maze& maze, size_t budget, vector<pair<int, int>>& path) override {
+        int target = query.endY * maze.getWidth() + query.endX;
+        nodesExpanded += field.extend(budget, target, trace);
+        if (field.path(query.endX, query.endY, path)) return SearchStatus::Found;
+        return field.isComplete() ? SearchStatus::NotFound : SearchStatus::Running;
     }
 };
+
+// имена доступных алгоритмов поиска пути (для выбора во время работы)
+inline const vector<string>& pathFinderNames() {
+    static const vector<string> names = {"backtracking", "bfs", "astar", "bibfs", "tree", "field"};
+    return names;
+}
+
+// создание алгоритма поиска пути по имени (nullptr, если имя неизвестно)
+inline unique_ptr<IPathFinder> makePathFinder(const string& name) {
+    if (name == "backtracking") return unique_ptr<IPathFinder>(new BacktrackingPathFinder());
+    if (name == "bfs") return unique_ptr<IPathFinder>(new BfsPathFinder());
+    if (name == "astar") return unique_ptr<IPathFinder>(new AStarPathFinder());
+    if (name == "bibfs") return unique_ptr<IPathFinder>(new BidirectionalBfsPathFinder());
+    if (name == "tree") return unique_ptr<IPathFinder>(new TreePathFinder());
+    if (name == "field") return unique_ptr<IPathFinder>(new DistanceFieldPathFinder());
+    return nullptr;
+}
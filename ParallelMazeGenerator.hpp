@@ -0,0 +1,116 @@
+#pragma once
+#include "MazeStrategy.hpp"
+#include "ThreadPool.hpp"
+#include <cmath>
+#include <numeric>
+
+// параллельная генерация по блокам
+//
+// лабиринт делится на прямоугольные блоки, каждый блок - независимый совершенный лабиринт
+// Эллера со своим зерном, блоки генерируются на пуле потоков. затем по сетке блоков строится
+// случайное остовное дерево (Краскал), и на границе каждой пары блоков - ребра дерева -
+// открывается ровно одна стена. дерево деревьев, соединенных деревом, - снова дерево,
+// поэтому результат - совершенный лабиринт. ширина блока кратна 64, так что блоки не делят
+// слова битовых рядов и пишут в сетку без синхронизации. результат детерминирован при
+// одинаковых зерне, размере и числе потоков (от числа потоков зависит разбиение на блоки).
+// в режиме Execution::CallerThread блоки с тем же разбиением генерируются подряд в вызывающем
+// потоке - лабиринт тот же, а потоки не создаются (для вызова из исполнителя другого пула).
+class ParallelBlockMazeGenerator : public IMazeGenerator {
+public:
+    // где генерируются блоки
+    enum class Execution {
+        Pool, // на собственном пуле потоков
+        CallerThread // в вызывающем потоке
+    };
+
+private:
+    WorkStealingPool pool; // исполнители
+    unsigned layoutThreads; // число потоков, под которое режутся блоки (от него зависит лабиринт)
+    uint64_t seed; // зерно следующей генерации
+
+    // корень множества в системе непересекающихся множеств
+    static int findRoot(vector<int>& parent, int item) {
+        while (parent[item] != item) item = parent[item] = parent[parent[item]];
+        return item;
+    }
+
+public:
+    // threads - число исполнителей (0 - по числу ядер)
+    explicit ParallelBlockMazeGenerator(unsigned threads = 0, uint64_t seed = (uint64_t(random_device{}()) << 32) | random_device{}(),
+        Execution execution = Execution::Pool)
+        : pool(execution == Execution::Pool ? threads : 1),
+          layoutThreads(execution == Execution::Pool ? pool.getThreadCount()
+              : threads ? threads : max(1u, thread::hardware_concurrency())),
+          seed(seed) {}
+
+    unsigned getLayoutThreads() const { return layoutThreads; }
+
+    uint64_t getSeed() const { return seed; }
+    void setSeed(uint64_t newSeed) { seed = newSeed; }
+
+    void generate(Maze& maze) override {
+        int width = maze.getWidth(), height = maze.getHeight();
+        if (width <= 0 || height <= 0) return;
+        size_t words = maze.getWordsPerRow();
+        uint64_t* base = maze.eastWalls(0); // указатель берется до параллельной части (он меняет версию)
+
+        // разбиение: около четырех блоков на исполнителя для балансировки, ширина блока кратна 64
+        int target = int(layoutThreads) * 4;
+        int columns = max(1, min((width + 63) / 64, int(lround(sqrt(double(target) * width / height)))));
+        int blockWidth = ((width + columns - 1) / columns + 63) / 64 * 64;
+        columns = (width + blockWidth - 1) / blockWidth;
+        int rows = max(1, min(height, (target + columns - 1) / columns));
+        int blockHeight = (height + rows - 1) / rows;
+        rows = (height + blockHeight - 1) / blockHeight;
+
+        // блоки генерируются независимо, каждый пишет только в свои слова сетки
+        pool.parallelFor(size_t(columns) * rows, 1, [&](unsigned, size_t begin, size_t end) {
+            for (size_t block = begin; block < end; ++block) {
+                int bx = int(block % columns), by = int(block / columns);
+                int x0 = bx * blockWidth, y0 = by * blockHeight;
+                int w = min(blockWidth, width - x0), h = min(blockHeight, height - y0);
+                struct BlockRows {
+                    uint64_t* origin; // первое слово блока в строке y0
+                    size_t stride; // слов на строку сетки
+                    size_t words; // слов на битовый ряд сетки
+                    uint64_t* east(int y) { return origin + size_t(y) * stride; }
+                    uint64_t* south(int y) { return east(y) + words; }
+                    bool commit(int) { return true; }
+                } blockRows{base + size_t(y0) * 2 * words + size_t(x0 / 64), 2 * words, words};
+                EllerMazeGenerator generator(mixBits64(seed ^ mixBits64(block)), EllerMazeGenerator::RandomMode::Counter);
+                generator.generateInto(w, h, (size_t(w) + 63) / 64, blockRows);
+            }
+        });
+
+        // остовное дерево по сетке блоков: ребро (блок, направление), 0 - вправо, 1 - вниз
+        vector<pair<int, int>> edges;
+        for (int block = 0; block < columns * rows; ++block) {
+            if (block % columns + 1 < columns) edges.push_back({block, 0});
+            if (block / columns + 1 < rows) edges.push_back({block, 1});
+        }
+        mt19937_64 rng(mixBits64(seed));
+        for (size_t i = edges.size(); i > 1; --i) swap(edges[i - 1], edges[rng() % i]); // перемешивание
+        vector<int> parent(size_t(columns) * rows);
+        iota(parent.begin(), parent.end(), 0);
+        for (const auto& edge : edges) {
+            int a = edge.first;
+            int b = edge.second == 0 ? a + 1 : a + columns;
+            int rootA = findRoot(parent, a), rootB = findRoot(parent, b);
+            if (rootA == rootB) continue;
+            parent[rootA] = rootB;
+
+            // открываем одну случайную стену на общей границе блоков
+            int x0 = (a % columns) * blockWidth, y0 = (a / columns) * blockHeight;
+            if (edge.second == 0) {
+                int y = y0 + int(rng() % uint64_t(min(blockHeight, height - y0)));
+                maze.setWall(x0 + blockWidth - 1, y, 1, false);
+            } else {
+                int x = x0 + int(rng() % uint64_t(min(blockWidth, width - x0)));
+                maze.setWall(x, y0 + blockHeight - 1, 2, false);
+            }
+        }
+        maze.setSeed(seed);
+        maze.setGenerator(MazeGeneratorKind::ParallelBlocks, layoutThreads); // от числа потоков зависят блоки
+        seed = mixBits64(seed); // следующая генерация даст другой лабиринт
+    }
+};
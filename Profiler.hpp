@@ -0,0 +1,190 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// встроенные замеры: таймеры участков (ProfileScope), счетчики и журнал событий для выгрузки
+//
+// замеры выключены по умолчанию: выключенный таймер стоит одну атомарную загрузку. включенные
+// записи идут под одной блокировкой (участки крупные: генерация, поиск, кадр), журнал -
+// кольцевой буфер последних MAX_EVENTS событий. имена - строковые литералы, ключ - указатель.
+// журнал выгружается в CSV или JSON (формат trace event, открывается chrome://tracing и Perfetto).
+class Profiler {
+public:
+    static constexpr size_t MAX_EVENTS = size_t(1) << 16; // событий в журнале
+
+    // статистика таймера
+    struct Timer {
+        uint64_t count = 0; // число замеров
+        double totalMs = 0; // суммарное время
+        double lastMs = 0; // последний замер
+        double maxMs = 0; // наибольший замер
+    };
+
+    // счетчик: сумма за все время и за последний завершенный кадр
+    struct Counter {
+        uint64_t total = 0;
+        uint64_t current = 0; // текущий кадр
+        uint64_t lastFrame = 0; // последний завершенный кадр
+    };
+
+    // событие журнала
+    struct Event {
+        const char* name;
+        uint64_t startUs; // начало от создания профилировщика
+        uint64_t durationUs;
+        uint32_t thread; // номер потока в порядке первого появления
+    };
+
+    static Profiler& instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    void setEnabled(bool state) { enabled.store(state, memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(memory_order_relaxed); }
+
+    // запись замера участка name
+    void record(const char* name, chrono::steady_clock::time_point start, chrono::steady_clock::time_point end) {
+        if (!isEnabled()) return;
+        double ms = chrono::duration<double, milli>(end - start).count();
+        lock_guard<mutex> guard(lock);
+        Timer& timer = timers[name];
+        ++timer.count;
+        timer.totalMs += ms;
+        timer.lastMs = ms;
+        timer.maxMs = max(timer.maxMs, ms);
+        Event event{name, uint64_t(chrono::duration_cast<chrono::microseconds>(start - origin).count()),
+            uint64_t(chrono::duration_cast<chrono::microseconds>(end - start).count()), threadIndex()};
+        if (events.size() < MAX_EVENTS) events.push_back(event);
+        else events[nextEvent] = event; // кольцо: затираем самое старое
+        nextEvent = (nextEvent + 1) % MAX_EVENTS;
+    }
+
+    // прибавление value к счетчику name
+    void count(const char* name, uint64_t value = 1) {
+        if (!isEnabled()) return;
+        lock_guard<mutex> guard(lock);
+        Counter& counter = counters[name];
+        counter.total += value;
+        counter.current += value;
+    }
+
+    // конец кадра: текущие значения счетчиков становятся значениями последнего кадра
+    void endFrame() {
+        lock_guard<mutex> guard(lock);
+        for (auto& entry : counters) {
+            entry.second.lastFrame = entry.second.current;
+            entry.second.current = 0;
+        }
+    }
+
+    // копии статистики, упорядоченные по имени
+    vector<pair<string, Timer>> getTimers() const {
+        lock_guard<mutex> guard(lock);
+        vector<pair<string, Timer>> result(timers.begin(), timers.end());
+        sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        return result;
+    }
+
+    vector<pair<string, Counter>> getCounters() const {
+        lock_guard<mutex> guard(lock);
+        vector<pair<string, Counter>> result(counters.begin(), counters.end());
+        sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        return result;
+    }
+
+    // выгрузка журнала: name,thread,start_us,duration_us по строке на событие
+    bool writeCsv(const string& path) const {
+        ofstream out(path, ios::trunc);
+        out << "name,thread,start_us,duration_us\n";
+        forEachEvent([&](const Event& event) {
+            out << event.name << "," << event.thread << "," << event.startUs << "," << event.durationUs << "\n";
+        });
+        return bool(out);
+    }
+
+    // выгрузка журнала в формате trace event (события "X") со сводкой таймеров и счетчиков
+    bool writeJson(const string& path) const {
+        ofstream out(path, ios::trunc);
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        forEachEvent([&](const Event& event) {
+            out << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                << event.thread << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs << "}";
+            first = false;
+        });
+        out << "\n],\"timers\":{";
+        first = true;
+        for (const auto& entry : getTimers()) {
+            out << (first ? "\n" : ",\n") << "\"" << entry.first << "\":{\"count\":" << entry.second.count
+                << ",\"total_ms\":" << entry.second.totalMs << ",\"max_ms\":" << entry.second.maxMs << "}";
+            first = false;
+        }
+        out << "\n},\"counters\":{";
+        first = true;
+        for (const auto& entry : getCounters()) {
+            out << (first ? "\n" : ",\n") << "\"" << entry.first << "\":" << entry.second.total;
+            first = false;
+        }
+        out << "\n}}\n";
+        return bool(out);
+    }
+
+private:
+    atomic<bool> enabled{false};
+    mutable mutex lock; // защищает все поля ниже
+    unordered_map<const char*, Timer> timers;
+    unordered_map<const char*, Counter> counters;
+    vector<Event> events; // кольцевой буфер журнала
+    size_t nextEvent = 0; // место следующего события
+    unordered_map<thread::id, uint32_t> threads; // номера потоков
+    chrono::steady_clock::time_point origin = chrono::steady_clock::now(); // начало отсчета журнала
+
+    Profiler() = default;
+
+    uint32_t threadIndex() {
+        auto it = threads.find(this_thread::get_id());
+        if (it != threads.end()) return it->second;
+        uint32_t index = uint32_t(threads.size());
+        threads.emplace(this_thread::get_id(), index);
+        return index;
+    }
+
+    // события журнала от старых к новым
+    void forEachEvent(const function<void(const Event&)>& visit) const {
+        lock_guard<mutex> guard(lock);
+        size_t first = events.size() < MAX_EVENTS ? 0 : nextEvent;
+        for (size_t i = 0; i < events.size(); ++i) visit(events[(first + i) % events.size()]);
+    }
+};
+
+// замер участка от создания до разрушения объекта (при включенном профилировщике)
+class ProfileScope {
+private:
+    const char* name;
+    bool active;
+    chrono::steady_clock::time_point start;
+
+public:
+    explicit ProfileScope(const char* name) : name(name), active(Profiler::instance().isEnabled()) {
+        if (active) start = chrono::steady_clock::now();
+    }
+
+    ~ProfileScope() {
+        if (active) Profiler::instance().record(name, start, chrono::steady_clock::now());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
@@ -0,0 +1,153 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// пул потоков с перехватом работы (work stealing) для параллельной обработки диапазонов
+//
+// диапазон [0, count) режется на куски по chunk элементов, куски заранее раздаются
+// исполнителям поровну подряд идущими группами. исполнитель берет куски из конца своей
+// очереди, а закончив свои - забирает куски из начала чужих очередей. потоки создаются
+// один раз и ждут следующего задания; вызывающий поток участвует как исполнитель 0.
+// parallelFor не реентерабелен: одновременно пул выполняет одно задание.
+class WorkStealingPool {
+private:
+    // очередь кусков одного исполнителя
+    struct Queue {
+        mutex lock;
+        deque<size_t> chunks;
+    };
+
+    vector<unique_ptr<Queue>> queues; // по очереди на исполнителя
+    vector<thread> threads; // рабочие потоки (исполнители 1..n-1)
+    mutex stateLock; // защищает поля задания ниже
+    condition_variable wake; // новое задание или остановка
+    condition_variable done; // все исполнители закончили задание
+    uint64_t job = 0; // номер текущего задания
+    unsigned active = 0; // рабочих потоков, еще не закончивших задание
+    bool stopping = false;
+    const function<void(unsigned, size_t, size_t)>* task = nullptr; // текущее задание
+    size_t count = 0; // размер диапазона
+    size_t chunk = 1; // размер куска
+    exception_ptr error; // первое исключение задания
+
+    // следующий кусок для исполнителя worker: сначала свой, потом украденный
+    bool takeChunk(unsigned worker, size_t& index) {
+        {
+            Queue& own = *queues[worker];
+            lock_guard<mutex> guard(own.lock);
+            if (!own.chunks.empty()) {
+                index = own.chunks.back();
+                own.chunks.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < queues.size(); ++k) { // перехват работы у других исполнителей
+            Queue& victim = *queues[(worker + k) % queues.size()];
+            lock_guard<mutex> guard(victim.lock);
+            if (!victim.chunks.empty()) {
+                index = victim.chunks.front();
+                victim.chunks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // выполнение кусков, пока они есть
+    void runChunks(unsigned worker) {
+        size_t index;
+        while (takeChunk(worker, index)) {
+            size_t begin = index * chunk;
+            size_t end = min(count, begin + chunk);
+            try {
+                (*task)(worker, begin, end);
+            } catch (...) {
+                lock_guard<mutex> guard(stateLock);
+                if (!error) error = current_exception();
+            }
+        }
+    }
+
+    void workerLoop(unsigned worker) {
+        uint64_t seen = 0; // последнее выполненное задание
+        for (;;) {
+            {
+                unique_lock<mutex> guard(stateLock);
+                wake.wait(guard, [&] { return stopping || job != seen; });
+                if (stopping) return;
+                seen = job;
+            }
+            runChunks(worker);
+            {
+                lock_guard<mutex> guard(stateLock);
+                if (--active == 0) done.notify_all();
+            }
+        }
+    }
+
+public:
+    // пул из threads исполнителей (0 - по числу ядер)
+    explicit WorkStealingPool(unsigned threadCount = 0) {
+        if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+        for (unsigned i = 0; i < threadCount; ++i) queues.emplace_back(new Queue());
+        for (unsigned i = 1; i < threadCount; ++i) threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+
+    ~WorkStealingPool() {
+        {
+            lock_guard<mutex> guard(stateLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : threads) worker.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // число исполнителей (включая вызывающий поток)
+    unsigned getThreadCount() const { return unsigned(queues.size()); }
+
+    // вызов body(worker, begin, end) для всех кусков [0, total) размером chunkSize;
+    // worker - номер исполнителя 0..getThreadCount()-1, возвращает управление после всех кусков.
+    // исключение из body пробрасывается вызывающему после завершения остальных кусков
+    void parallelFor(size_t total, size_t chunkSize, const function<void(unsigned, size_t, size_t)>& body) {
+        if (total == 0) return;
+        chunkSize = max<size_t>(1, chunkSize);
+        size_t chunks = (total + chunkSize - 1) / chunkSize;
+        size_t workers = queues.size();
+        for (size_t w = 0; w < workers; ++w) { // раздаем куски подряд идущими группами
+            lock_guard<mutex> guard(queues[w]->lock);
+            for (size_t c = chunks * w / workers; c < chunks * (w + 1) / workers; ++c) {
+                queues[w]->chunks.push_front(c); // свои куски исполнитель берет с конца - по возрастанию
+            }
+        }
+        {
+            lock_guard<mutex> guard(stateLock);
+            task = &body;
+            count = total;
+            chunk = chunkSize;
+            error = nullptr;
+            active = unsigned(threads.size());
+            ++job;
+        }
+        wake.notify_all();
+        runChunks(0);
+
+        unique_lock<mutex> guard(stateLock);
+        done.wait(guard, [&] { return active == 0; });
+        task = nullptr;
+        if (error) rethrow_exception(error);
+    }
+};
@@ -0,0 +1,61 @@
+#include "MazeBatch.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// пакетный режим без окна: задания (см. MazeBatch.hpp) читаются из файла или стандартного ввода
+// запуск: maze_batch [--threads N] [--binary] [--timing] [--mazes DIR] [--output FILE] [файл заданий]
+
+int main(int argc, char* argv[]) {
+    MazeBatchRunner::Options options;
+    const char* inputPath = nullptr; // без файла задания читаются из стандартного ввода
+    const char* outputPath = nullptr; // без файла результаты пишутся в стандартный вывод
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) options.threads = unsigned(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--binary") == 0) options.binary = true;
+        else if (strcmp(argv[i], "--timing") == 0) options.timing = true;
+        else if (strcmp(argv[i], "--mazes") == 0 && i + 1 < argc) options.mazeDirectory = argv[++i];
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) outputPath = argv[++i];
+        else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            cerr << "Неизвестный параметр: " << argv[i] << "\n";
+            return 2;
+        }
+        else inputPath = argv[i];
+    }
+
+    ifstream inputFile;
+    if (inputPath && strcmp(inputPath, "-") != 0) {
+        inputFile.open(inputPath);
+        if (!inputFile) {
+            cerr << "Не удалось открыть файл заданий: " << inputPath << "\n";
+            return 2;
+        }
+    }
+    ofstream outputFile;
+    if (outputPath) {
+        outputFile.open(outputPath, ios::binary | ios::trunc);
+        if (!outputFile) {
+            cerr << "Не удалось создать файл результатов: " << outputPath << "\n";
+            return 2;
+        }
+    }
+    istream& in = inputFile.is_open() ? static_cast<istream&>(inputFile) : cin;
+    ostream& out = outputFile.is_open() ? static_cast<ostream&>(outputFile) : cout;
+    ios::sync_with_stdio(false);
+
+    MazeBatchRunner runner(options);
+    auto start = chrono::steady_clock::now();
+    MazeBatchRunner::Summary summary = runner.run(in, out);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // итоги - в поток ошибок, чтобы не смешиваться с результатами
+    cerr << "jobs " << summary.jobs << " (errors " << summary.failed << "), queries " << summary.queries
+         << ", cells " << summary.cells << ", threads " << runner.getThreadCount() << ", "
+         << seconds << " s, " << (seconds > 0 ? summary.cells / seconds / 1e6 : 0) << " Mcells/s\n";
+    if (!out) {
+        cerr << "Ошибка записи результатов\n";
+        return 1;
+    }
+    return summary.failed ? 1 : 0;
+}
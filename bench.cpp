@@ -0,0 +1,356 @@
+#include "BatchPathSolver.hpp"
+#include "BitParallelBfs.hpp"
+#include "ParallelMazeGenerator.hpp"
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+// бенчмарк генерации и поиска пути на фиксированных зернах (без дисплея)
+// запуск: maze_bench [--max-size N] [--queries N] [--seed N] [--threads N]
+//         maze_bench --check - самопроверка алгоритмов и формата файла (для ctest)
+
+using BenchClock = chrono::steady_clock;
+
+// параметры запуска
+struct BenchOptions {
+    int maxSize = 1000; // наибольшая сторона лабиринта
+    int queries = 200; // запросов поиска пути на размер (на больших размерах меньше)
+    uint32_t seed = 12345; // базовое зерно генерации и запросов
+    unsigned threads = 0; // исполнителей пакетных запросов (0 - по числу ядер)
+};
+
+// время в микросекундах между двумя моментами
+static double microsecondsBetween(BenchClock::time_point from, BenchClock::time_point to) {
+    return chrono::duration<double, micro>(to - from).count();
+}
+
+// перцентиль p (0..100) по отсортированным значениям
+static double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = size_t(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[min(index, sorted.size() - 1)];
+}
+
+// все проверяемые алгоритмы поиска пути
+static vector<unique_ptr<IPathFinder>> makeFinders() {
+    vector<unique_ptr<IPathFinder>> finders;
+    for (const auto& name : pathFinderNames()) finders.push_back(makePathFinder(name));
+    return finders;
+}
+
+static bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc) options.maxSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) options.queries = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) options.seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) options.threads = unsigned(atoi(argv[++i]));
+        else {
+            cerr << "Неизвестный параметр: " << argv[i] << "\n"
+                 << "запуск: maze_bench [--max-size N] [--queries N] [--seed N] [--threads N] | --check\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// итоги проверок режима --check
+struct CheckResult {
+    size_t checks = 0;
+    size_t failures = 0;
+
+    // учет одной проверки: при расхождении печатается what
+    void expect(bool ok, const string& what) {
+        ++checks;
+        if (ok) return;
+        ++failures;
+        cerr << "check: " << what << "\n";
+    }
+};
+
+// имя лабиринта и точки для сообщений о расхождении
+static string describe(const string& label, const Maze& maze, int x, int y) {
+    return label + " " + to_string(maze.getWidth()) + "x" + to_string(maze.getHeight()) +
+        " от (" + to_string(x) + ", " + to_string(y) + ")";
+}
+
+// сверка BitParallelBfs с полем расстояний (обычный поиск в ширину): запросы на одном
+// экземпляре чередуются, чтобы проверить частичную очистку буферов между ними
+static void checkBitBfs(const Maze& maze, const string& label, mt19937& rng, BitParallelBfs& bits, CheckResult& result) {
+    int w = maze.getWidth(), h = maze.getHeight();
+    uniform_int_distribution<int> cx(0, w - 1), cy(0, h - 1);
+    DistanceField field;
+    for (int source = 0; source < 6; ++source) {
+        int sx = cx(rng), sy = cy(rng);
+        field.reset(maze, sx, sy);
+        field.extend(SIZE_MAX);
+        size_t reachable = 0;
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) reachable += field.distance(x, y) >= 0;
+        }
+        string where = describe(label, maze, sx, sy);
+        result.expect(bits.layerCount(maze, sx, sy) == field.getMaxDistance() + 1, "bitbfs: число слоев, " + where);
+        for (int q = 0; q < 8; ++q) {
+            int ex = cx(rng), ey = cy(rng);
+            result.expect(bits.distance(maze, sx, sy, ex, ey) == field.distance(ex, ey), "bitbfs: расстояние, " + where);
+        }
+        result.expect(bits.fill(maze, sx, sy) == reachable, "bitbfs: заливка, " + where);
+        int ex = cx(rng), ey = cy(rng); // поиск сразу после заливки
+        result.expect(bits.distance(maze, sx, sy, ex, ey) == field.distance(ex, ey), "bitbfs: расстояние, " + where);
+    }
+}
+
+// сверка алгоритмов поиска пути с bfs на запросах pairs: длина пути должна совпасть, кроме
+// backtracking (путь не кратчайший) и tree на лабиринте с циклами (путь по остовному дереву) -
+// у них совпадать должно только наличие пути
+static void checkPathLengths(const Maze& maze, const string& label, bool acyclic,
+    const vector<array<int, 4>>& pairs, CheckResult& result) {
+    BfsPathFinder reference;
+    vector<pair<int, int>> expected, path;
+    for (auto& finder : makeFinders()) {
+        string name = finder->getName();
+        bool shortest = name != "backtracking" && (name != "tree" || acyclic);
+        for (const auto& q : pairs) {
+            bool found = reference.findPath(maze, q[0], q[1], q[2], q[3], expected);
+            bool same = finder->findPath(maze, q[0], q[1], q[2], q[3], path) == found &&
+                (!shortest || path.size() == expected.size());
+            result.expect(same, name + ": путь до (" + to_string(q[2]) + ", " + to_string(q[3]) + "), " +
+                describe(label, maze, q[0], q[1]));
+        }
+    }
+}
+
+// сохранение и открытие: размеры, зерно, генератор и стены совпадают; файл с открытой
+// внешней границей не открывается
+static void checkSaveOpen(const Maze& maze, const string& label, CheckResult& result) {
+    const string path = "maze_check.maze"; // в рабочем каталоге (у ctest - каталог сборки)
+    string where = describe(label, maze, 0, 0);
+    try {
+        maze.save(path);
+        Maze loaded = Maze::open(path);
+        bool same = loaded.getWidth() == maze.getWidth() && loaded.getHeight() == maze.getHeight() &&
+            loaded.getSeed() == maze.getSeed() && loaded.getGeneratorKind() == maze.getGeneratorKind() &&
+            loaded.getGeneratorThreads() == maze.getGeneratorThreads();
+        for (int y = 0; same && y < maze.getHeight(); ++y) {
+            size_t bytes = maze.getWordsPerRow() * sizeof(uint64_t);
+            same = memcmp(loaded.eastWalls(y), maze.eastWalls(y), bytes) == 0 &&
+                memcmp(loaded.southWalls(y), maze.southWalls(y), bytes) == 0;
+        }
+        result.expect(same, "save/open: лабиринт изменился, " + where);
+
+        // правая стена последнего столбца первой строки снята прямо в файле
+        FILE* file = fopen(path.c_str(), "r+b");
+        uint64_t word = 0;
+        long offset = long(sizeof(MazeFileHeader) + (maze.getWordsPerRow() - 1) * sizeof(uint64_t));
+        bool written = file && fseek(file, offset, SEEK_SET) == 0 && fread(&word, sizeof(word), 1, file) == 1;
+        word &= ~(uint64_t(1) << ((maze.getWidth() - 1) & 63));
+        written = written && fseek(file, offset, SEEK_SET) == 0 && fwrite(&word, sizeof(word), 1, file) == 1;
+        if (file) fclose(file);
+        bool rejected = false;
+        try {
+            Maze::open(path);
+        } catch (const exception&) {
+            rejected = true;
+        }
+        result.expect(written && rejected, "save/open: открыта граница, " + where);
+    } catch (const exception& error) {
+        result.expect(false, string("save/open: ") + error.what() + ", " + where);
+    }
+    remove(path.c_str());
+}
+
+// лабиринт, построенный вручную
+struct HandMaze {
+    string label;
+    Maze maze;
+    bool acyclic; // без циклов (дерево или лес)
+};
+
+// небольшие лабиринты с известным устройством: несвязные, с циклами и вырожденные
+static vector<HandMaze> handBuiltMazes() {
+    vector<HandMaze> mazes;
+    Maze split(4, 1); // открыт только проход (2,0)-(3,0): у tree пара в нем не находилась
+    split.setWall(2, 0, 1, false);
+    mazes.push_back({"split", split, true});
+
+    Maze open(5, 4); // все стены сняты: циклы всюду
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 5; ++x) {
+            open.setWall(x, y, 1, false);
+            open.setWall(x, y, 2, false);
+        }
+    }
+    mazes.push_back({"open", open, false});
+
+    Maze ring(3, 3); // кольцо по краю и отрезанная центральная клетка
+    for (int i = 0; i < 2; ++i) {
+        ring.setWall(i, 0, 1, false);
+        ring.setWall(i, 2, 1, false);
+        ring.setWall(0, i, 2, false);
+        ring.setWall(2, i, 2, false);
+    }
+    mazes.push_back({"ring", ring, false});
+
+    Maze combs(7, 5); // три гребенки в столбцах 0-1, 3-4 и 6, разделенные стенами
+    for (int x : {0, 3}) {
+        for (int y = 0; y < 5; ++y) combs.setWall(x, y, 1, false);
+        for (int y = 0; y < 4; ++y) combs.setWall(x, y, 2, false);
+    }
+    for (int y = 0; y < 4; ++y) combs.setWall(6, y, 2, false);
+    mazes.push_back({"combs", combs, true});
+
+    mazes.push_back({"single", Maze(1, 1), true});
+    return mazes;
+}
+
+// самопроверка для ctest: битовый поиск против обычного, длины путей всех алгоритмов против
+// bfs и сохранение/открытие - на лабиринтах, построенных вручную, и на случайных, где после
+// генерации часть стен снимается (циклы) или ставится (несвязные области)
+static int runCheck(uint32_t seed) {
+    CheckResult result;
+    mt19937 rng(seed);
+    BitParallelBfs bits;
+
+    for (const HandMaze& hand : handBuiltMazes()) {
+        vector<array<int, 4>> pairs; // все пары клеток
+        int w = hand.maze.getWidth(), h = hand.maze.getHeight();
+        for (int from = 0; from < w * h; ++from) {
+            for (int to = 0; to < w * h; ++to) pairs.push_back({from % w, from / w, to % w, to / w});
+        }
+        checkPathLengths(hand.maze, hand.label, hand.acyclic, pairs, result);
+        checkBitBfs(hand.maze, hand.label, rng, bits, result);
+        checkSaveOpen(hand.maze, hand.label, result);
+    }
+
+    const int sizes[][2] = {{1, 1}, {1, 7}, {7, 1}, {63, 5}, {64, 4}, {65, 6}, {130, 9}, {257, 12}, {300, 40}, {513, 3}};
+    for (int round = 0; round < 4; ++round) {
+        bool closing = round & 1; // нечетные раунды ставят стены, четные - снимают
+        for (const auto& size : sizes) {
+            int w = size[0], h = size[1];
+            Maze maze(w, h);
+            EllerMazeGenerator(rng()).generate(maze);
+            uniform_int_distribution<int> cx(0, w - 1), cy(0, h - 1), dir(0, 3);
+            int edits = w * h / 8;
+            for (int i = 0; i < edits; ++i) maze.setWall(cx(rng), cy(rng), dir(rng), closing);
+            string label = closing ? "random+walls" : "random+loops";
+            vector<array<int, 4>> pairs(16);
+            for (auto& q : pairs) q = {cx(rng), cy(rng), cx(rng), cy(rng)};
+            checkPathLengths(maze, label, closing || edits == 0, pairs, result);
+            checkBitBfs(maze, label, rng, bits, result);
+            checkSaveOpen(maze, label, result);
+        }
+    }
+    cout << "check: " << result.checks - result.failures << "/" << result.checks << " совпадений\n";
+    return result.failures ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 2 && strcmp(argv[1], "--check") == 0) return runCheck(12345);
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) return 2;
+    const int sizes[] = {5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000};
+
+    cout << fixed << setprecision(1);
+    cout << "seed " << options.seed << ", max size " << options.maxSize << "\n\n";
+
+    for (int size : sizes) {
+        if (size > options.maxSize) break;
+        double cells = double(size) * size;
+
+        // генерация: повторяем, пока не наберется около миллиона клеток
+        Maze maze(size, size);
+        EllerMazeGenerator generator(options.seed + uint32_t(size));
+        int repeats = max(1, int(1e6 / cells));
+        auto begin = BenchClock::now();
+        for (int i = 0; i < repeats; ++i) generator.generate(maze);
+        double seconds = microsecondsBetween(begin, BenchClock::now()) / 1e6;
+        cout << "generate eller      " << setw(5) << size << "x" << left << setw(6) << size << right
+             << setw(12) << cells * repeats / seconds / 1e6 << " Mcells/s\n";
+
+        // счетный режим случайных бит: строки не зависят друг от друга
+        EllerMazeGenerator counterGenerator(options.seed + uint32_t(size), EllerMazeGenerator::RandomMode::Counter);
+        begin = BenchClock::now();
+        for (int i = 0; i < repeats; ++i) counterGenerator.generate(maze);
+        seconds = microsecondsBetween(begin, BenchClock::now()) / 1e6;
+        cout << "generate counter    " << setw(5) << size << "x" << left << setw(6) << size << right
+             << setw(12) << cells * repeats / seconds / 1e6 << " Mcells/s\n";
+        generator.setSeed(options.seed + uint32_t(size)); // поиск идет по лабиринту первого зерна
+        generator.generate(maze);
+
+        // параллельная генерация по блокам на том же числе исполнителей, что и пакетный поиск
+        ParallelBlockMazeGenerator parallelGenerator(options.threads, options.seed + uint64_t(size));
+        Maze parallelMaze(size, size);
+        begin = BenchClock::now();
+        for (int i = 0; i < repeats; ++i) parallelGenerator.generate(parallelMaze);
+        seconds = microsecondsBetween(begin, BenchClock::now()) / 1e6;
+        cout << "generate parallel   " << setw(5) << size << "x" << left << setw(6) << size << right
+             << setw(12) << cells * repeats / seconds / 1e6 << " Mcells/s\n";
+
+        // поиск пути: одинаковые случайные запросы для всех алгоритмов
+        int queries = max(10, min(options.queries, int(2e8 / cells)));
+        mt19937 queryRng(options.seed ^ uint32_t(size * 7919));
+        uniform_int_distribution<int> coord(0, size - 1);
+        vector<array<int, 4>> pairs(queries);
+        for (auto& q : pairs) q = {coord(queryRng), coord(queryRng), coord(queryRng), coord(queryRng)};
+
+        for (auto& finder : makeFinders()) {
+            vector<double> latencies;
+            double expanded = 0;
+            size_t failures = 0;
+            vector<pair<int, int>> path; // переиспользуется между запросами
+            for (const auto& q : pairs) {
+                auto start = BenchClock::now();
+                bool found = finder->findPath(maze, q[0], q[1], q[2], q[3], path);
+                latencies.push_back(microsecondsBetween(start, BenchClock::now()));
+                expanded += double(finder->getNodesExpanded());
+                if (!found) ++failures;
+            }
+            sort(latencies.begin(), latencies.end());
+            cout << "path   " << left << setw(13) << finder->getName() << right << setw(5) << size << "x"
+                 << left << setw(6) << size << right << " q=" << setw(5) << queries
+                 << "  p50 " << setw(10) << percentile(latencies, 50)
+                 << "  p90 " << setw(10) << percentile(latencies, 90)
+                 << "  p99 " << setw(10) << percentile(latencies, 99) << " us"
+                 << "  expanded " << setw(12) << expanded / queries;
+            if (failures) cout << "  (не найдено: " << failures << ")";
+            cout << "\n";
+
+            // пакетный режим: те же запросы на пуле потоков
+            BatchPathSolver solver(*finder, options.threads);
+            vector<PathQuery> batch;
+            for (const auto& q : pairs) batch.push_back({q[0], q[1], q[2], q[3]});
+            vector<PathResult> results(batch.size());
+            solver.solve(maze, batch, results); // прогрев: рабочие состояния исполнителей
+            auto batchStart = BenchClock::now();
+            solver.solve(maze, batch, results);
+            double batchSeconds = microsecondsBetween(batchStart, BenchClock::now()) / 1e6;
+            cout << "batch  " << left << setw(13) << finder->getName() << right << setw(5) << size << "x"
+                 << left << setw(6) << size << right << " threads " << solver.getThreadCount()
+                 << setw(14) << batch.size() / batchSeconds << " queries/s\n";
+        }
+
+        // битовый поиск в ширину: только длина пути (сравнивать с bfs), и заливка всего лабиринта
+        BitParallelBfs bits;
+        vector<double> latencies;
+        for (const auto& q : pairs) {
+            auto start = BenchClock::now();
+            bits.distance(maze, q[0], q[1], q[2], q[3]);
+            latencies.push_back(microsecondsBetween(start, BenchClock::now()));
+        }
+        sort(latencies.begin(), latencies.end());
+        cout << "dist   " << left << setw(13) << "bitbfs" << right << setw(5) << size << "x"
+             << left << setw(6) << size << right << " q=" << setw(5) << queries
+             << "  p50 " << setw(10) << percentile(latencies, 50)
+             << "  p90 " << setw(10) << percentile(latencies, 90)
+             << "  p99 " << setw(10) << percentile(latencies, 99) << " us\n";
+        begin = BenchClock::now();
+        for (int i = 0; i < repeats; ++i) bits.fill(maze, 0, 0);
+        seconds = microsecondsBetween(begin, BenchClock::now()) / 1e6;
+        cout << "fill   bits         " << setw(5) << size << "x" << left << setw(6) << size << right
+             << setw(12) << cells * repeats / seconds / 1e6 << " Mcells/s\n";
+        cout << "\n";
+    }
+    return 0;
+}
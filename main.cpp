@@ -1,4 +1,8 @@
-#include "MazeStrategy.hpp"
+#include "MazeRenderer.hpp"
+#include "BackgroundMazeGenerator.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
@@ -28,30 +32,117 @@ pair<int, int> chooseMazeSize() {
     }
 }
 
-int main() {
+// команда, которая заново получает этот лабиринт (размер, зерно и генератор берутся из лабиринта);
+// пустая строка - генератор неизвестен
+string reproduceCommand(const Maze& maze) {
+    string size = to_string(maze.getWidth()) + " " + to_string(maze.getHeight());
+    string seed = to_string(maze.getSeed());
+    switch (maze.getGeneratorKind()) {
+    case MazeGeneratorKind::Eller:
+        return "maze --size " + size + " --seed " + seed;
+    case MazeGeneratorKind::EllerCounter:
+        return "maze --size " + size + " --seed " + seed + " --counter-rng";
+    case MazeGeneratorKind::ParallelBlocks: // генератор по блокам есть только в пакетном режиме
+        return "echo \"" + size + " " + seed + " parallel:" + to_string(maze.getGeneratorThreads()) +
+            " none\" | maze_batch --mazes <каталог>";
+    default:
+        return "";
+    }
+}
+
+// вывод зерна и команды повтора лабиринта
+void reportSeed(const Maze& maze) {
+    string command = reproduceCommand(maze);
+    cout << "Зерно лабиринта: " << maze.getSeed();
+    if (command.empty()) cout << " (генератор неизвестен)\n";
+    else cout << ", повторить: " << command << "\n";
+}
+
+// вывод результата поиска пути
+void reportPath(const IPathFinder& finder, const vector<pair<int, int>>& path) {
+    if (!path.empty()) {
+        cout << "Путь найден! (" << finder.getName() << ": длина " << path.size()
+             << ", раскрыто ячеек " << finder.getNodesExpanded() << ")\n\n";
+    } else {
+        cout << "Путь не найден!\n\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // запуск: maze [--size W H] [--seed N] [--counter-rng] [файл]
+    // --size - размер без вопроса в консоли, --seed - зерно генерации (одинаковые зерно, размер
+    // и режим дают один и тот же лабиринт), --counter-rng - счетный режим случайных бит,
+    // файл - открыть лабиринт из бинарного файла
+    EllerMazeGenerator generator; // генератор лабиринта (алгоритм Эллера), зерно по умолчанию случайное
+    const char* mazePath = nullptr;
+    pair<int, int> requestedSize = {0, 0}; // размер из --size (0 - спросить)
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--size") == 0 && i + 2 < argc) {
+            requestedSize = {atoi(argv[i + 1]), atoi(argv[i + 2])};
+            i += 2;
+            if (requestedSize.first <= 0 || requestedSize.second <= 0) {
+                cerr << "Размер лабиринта должен быть положительным\n";
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) generator.setSeed(strtoull(argv[++i], nullptr, 10));
+        else if (strcmp(argv[i], "--counter-rng") == 0) generator.setRandomMode(EllerMazeGenerator::RandomMode::Counter);
+        else if (argv[i][0] == '-') {
+            cerr << "Неизвестный параметр: " << argv[i] << "\n";
+            cerr << "Запуск: maze [--size W H] [--seed N] [--counter-rng] [файл]\n";
+            return 2;
+        }
+        else mazePath = argv[i];
+    }
+
+    Maze maze(0, 0);
+    if (mazePath) {
+        try {
+            maze = Maze::open(mazePath);
+        } catch (const exception& e) {
+            cerr << "Не удалось открыть лабиринт: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
     // выбор размера лабиринта
-    auto [width, height] = chooseMazeSize();
+    auto [width, height] = maze.getWidth() > 0 ? make_pair(maze.getWidth(), maze.getHeight())
+        : requestedSize.first > 0 ? requestedSize : chooseMazeSize();
     
-    // cоздаем окно с подходящим размером
+    // cоздаем окно с подходящим размером (не больше экрана, остальное - через камеру)
     const int MIN_WINDOW_SIZE = 300; // минимальная ширина и высота окна
     const int CELL_PIXELS = 30; // размер клетки в пикселях
-    const int windowWidth = std::max(MIN_WINDOW_SIZE, width * CELL_PIXELS); // ширина окна
-    const int windowHeight = std::max(MIN_WINDOW_SIZE, height * CELL_PIXELS); // высота окна
-    const float CELL_SIZE = std::min(float(windowWidth) / width, float(windowHeight) / height); // размер клетки
+    const sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
+    const int mazeWidthPixels = std::max(MIN_WINDOW_SIZE, width * CELL_PIXELS); // лабиринт целиком в масштабе 1:1
+    const int mazeHeightPixels = std::max(MIN_WINDOW_SIZE, height * CELL_PIXELS);
+    const int windowWidth = std::min(mazeWidthPixels, int(desktop.width * 9 / 10)); // ширина окна
+    const int windowHeight = std::min(mazeHeightPixels, int(desktop.height * 9 / 10)); // высота окна
+    const float CELL_SIZE = std::min(float(mazeWidthPixels) / width, float(mazeHeightPixels) / height); // размер клетки в единицах мира
 
     // создаем окно
     sf::RenderWindow window(sf::VideoMode(windowWidth, windowHeight), "LABIRINT");
     window.setFramerateLimit(60); // лимит кадров в секунду
 
-    // создаем лабиринт
-    Maze maze(width, height);
-    
-    // создаем генератор лабиринта (используем алгоритм Эллера)
-    EllerMazeGenerator generator; // создаем экземпляр генератора
-    generator.generate(maze); // генерируем лабиринт
+    // камера: колесо мыши - масштаб, средняя кнопка или стрелки - перемещение
+    Camera camera(width * CELL_SIZE, height * CELL_SIZE, CELL_SIZE);
+    camera.fit(window.getSize());
+    sf::Vector2u windowSize = window.getSize(); // размер окна для пересчета вида
+    bool dragging = false; // перетаскивание вида средней кнопкой
+    sf::Vector2i dragPixel; // последняя позиция курсора при перетаскивании
+
+    // генерация идет в фоновом потоке, окно показывает готовые строки по мере появления
+    BackgroundMazeGenerator background;
+    if (maze.getWidth() == 0) { // если лабиринт не загружен из файла
+        maze = Maze(width, height); // создаем лабиринт
+        background.start(maze, generator); // генерируем лабиринт
+    }
+    reportSeed(maze);
 
-    // создаем искатель пути (используем алгоритм бэктрекинга)
-    BacktrackingPathFinder pathFinder; // создаем экземпляр искателя пути
+    // создаем искатель пути (по умолчанию поле расстояний от начальной точки, цифровые клавиши переключают алгоритм)
+    const auto& finderNames = pathFinderNames();
+    const size_t fieldIndex = size_t(find(finderNames.begin(), finderNames.end(), "field") - finderNames.begin());
+    size_t finderIndex = fieldIndex; // индекс в pathFinderNames()
+    unique_ptr<IPathFinder> pathFinder = makePathFinder(finderNames[finderIndex]);
     vector<pair<int, int>> path; // путь между точками (startX, startY и endX, endY)
     bool pathFound = false; // флаг наличия этого пути
 
@@ -61,31 +152,134 @@ int main() {
     bool startPointSelected = false; // флаг выбора начальной точки (начальная точка не может быть равна конечной)
     bool endPointSelected = false; // флаг выбора конечной точки (конечная точка не может быть равна начальной)
 
+    // отрисовщики: геометрия лабиринта и наложения кэшируется между кадрами
+    MazeRenderer mazeRenderer; // стены лабиринта (пересобираются при изменении лабиринта)
+    OverlayRenderer overlay; // путь и точки (пересобираются при изменении выбора)
+    SearchRenderer searchView; // раскрытые ячейки и фронт идущего поиска
+    HeatmapRenderer heatmap; // расстояния от начальной точки (алгоритм field)
+    bool heatmapVisible = false; // тепловая карта включена (клавиша H)
+
+    // замеры: генерация, поиск, отрисовка, кадр; F3 - сводка на экране, F12 - выгрузка журнала
+    Profiler::instance().setEnabled(true);
+    ProfilerHud hud;
+    bool hudVisible = false;
+    auto titleUpdate = chrono::steady_clock::now(); // последнее обновление заголовка (если нет шрифта)
+    bool overlayDirty = true; // флаг необходимости пересборки наложения
+
+    // перерисовка по событиям: без работы и изменений цикл спит в waitEvent. слой лабиринта
+    // (тепловая карта и стены) кэшируется в текстуре размером с окно и перерисовывается, только
+    // когда меняются вид, лабиринт или карта; иначе кадр - одна копия слоя и наложения поверх
+    sf::RenderTexture mazeLayer; // кэш слоя лабиринта в пикселях окна
+    bool mazeLayerDirty = true; // слой нужно перерисовать
+    bool redraw = true; // кадр нужно показать
+    uint64_t layerRevision = 0; // версия лабиринта в слое
+    int layerRows = -1; // готовых строк в слое (во время генерации)
+    const sf::Time GENERATION_POLL = sf::milliseconds(5); // пауза опроса, пока фоновая генерация не дала строк
+    bool layerHeatmap = false; // в слое есть тепловая карта
+    mazeLayer.create(windowSize.x, windowSize.y);
+
+    // поиск пути идет по шагам, каждый кадр - не дольше SEARCH_BUDGET, чтобы окно не замирало
+    const chrono::milliseconds SEARCH_BUDGET(8); // время поиска за кадр
+    const size_t SEARCH_STEP_CELLS = 4096; // раскрытий за шаг между проверками времени
+    bool searching = false; // идет пошаговый поиск
+    vector<int> expandedCells; // ячейки, раскрытые с прошлого кадра
+    vector<int> frontierCells; // текущий фронт поиска
+
+    // запуск пошагового поиска между выбранными точками (идущий поиск отменяется)
+    auto startSearch = [&]() {
+        searchView.clear();
+        expandedCells.clear();
+        pathFound = false;
+        pathFinder->setTrace(&expandedCells);
+        pathFinder->beginSearch(maze, startX, startY, endX, endY);
+        searching = true;
+        overlayDirty = true;
+    };
+
+    // отмена идущего поиска
+    auto cancelSearch = [&]() {
+        pathFinder->cancelSearch();
+        searching = false;
+        searchView.clear();
+    };
+
     cout << "\nУправление:\n";
     cout << "- Левая кнопка мыши: выбор начальной и конечной точек пути\n";
     cout << "- Правая кнопка мыши: генерация нового лабиринта\n";
-    cout << "- Третий клик ЛКМ или пробел: сброс выбранных точек\n\n";
+    cout << "- Следующие клики ЛКМ: перенос конечной точки (поиск начинается заново)\n";
+    cout << "- Пробел: сброс выбранных точек, Escape: остановка поиска\n";
+    cout << "- H: тепловая карта расстояний от начальной точки (алгоритм field)\n";
+    cout << "- F3: замеры производительности, F12: выгрузка журнала замеров в maze_trace.csv и maze_trace.json\n";
+    cout << "- S: сохранение лабиринта в maze.bin\n";
+    cout << "- 1-" << pathFinderNames().size() << ": выбор алгоритма поиска пути (";
+    for (size_t i = 0; i < pathFinderNames().size(); ++i) cout << (i ? ", " : "") << pathFinderNames()[i];
+    cout << ")\n";
+    cout << "- Колесо мыши: масштаб, средняя кнопка или стрелки: перемещение, Home: весь лабиринт\n\n";
 
     // основной цикл программы
     while (window.isOpen()) {
+        auto frameStart = chrono::steady_clock::now();
+        if (background.poll()) { // фоновая генерация закончилась
+            cout << "Лабиринт сгенерирован\n\n";
+        }
+        bool generating = background.isRunning(); // пока лабиринт генерируется, поиск и сохранение недоступны
+
+        // без фоновой работы и изменений ждем событие, не занимая процессор
+        auto* fieldFinder = dynamic_cast<DistanceFieldPathFinder*>(pathFinder.get());
+        bool buildingHeatmap = heatmapVisible && fieldFinder && startPointSelected && !generating &&
+            !(fieldFinder->getField().isValidFor(maze, startX, startY) && fieldFinder->getField().isComplete());
+        bool idle = !generating && !searching && !buildingHeatmap && !mazeRenderer.hasPendingWork() && !redraw;
+
         sf::Event event; // sf::Event - класс для обработки событий
-        while (window.pollEvent(event)) {
+        bool hasEvent = idle ? window.waitEvent(event) : window.pollEvent(event);
+        for (; hasEvent; hasEvent = window.pollEvent(event)) {
+            if (event.type != sf::Event::MouseMoved || dragging) redraw = true; // почти любое событие меняет кадр
             if (event.type == sf::Event::Closed) { // если закрываем окно, то остановка программы
                 window.close();
             }
+            else if (event.type == sf::Event::Resized) { // изменение размера окна
+                sf::Vector2u newSize(event.size.width, event.size.height);
+                camera.resize(windowSize, newSize);
+                windowSize = newSize;
+                mazeLayer.create(windowSize.x, windowSize.y);
+                mazeLayerDirty = true;
+            }
+            else if (event.type == sf::Event::MouseWheelScrolled) { // масштаб колесом мыши
+                float factor = event.mouseWheelScroll.delta > 0 ? 0.8f : 1.25f;
+                camera.zoomAt(window, {event.mouseWheelScroll.x, event.mouseWheelScroll.y}, factor);
+                mazeLayerDirty = true;
+            }
+            else if (event.type == sf::Event::MouseMoved && dragging) { // перетаскивание вида
+                sf::Vector2i pixel(event.mouseMove.x, event.mouseMove.y);
+                camera.pan(window, dragPixel, pixel);
+                dragPixel = pixel;
+                mazeLayerDirty = true;
+            }
+            else if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Middle) {
+                dragging = false;
+            }
             else if (event.type == sf::Event::MouseButtonPressed) { // если нажата кнопка мыши
-                if (event.mouseButton.button == sf::Mouse::Left) { // ЛКМ
-                    // преобразуем координаты мыши в координаты ячейки
-                    int x = event.mouseButton.x / CELL_SIZE; // деление на размер клетки (для корректной работы)
-                    int y = event.mouseButton.y / CELL_SIZE;
+                if (event.mouseButton.button == sf::Mouse::Middle) { // средняя кнопка - начало перетаскивания
+                    dragging = true;
+                    dragPixel = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+                }
+                else if (event.mouseButton.button == sf::Mouse::Left) { // ЛКМ
+                    // преобразуем координаты мыши в координаты ячейки через текущий вид камеры
+                    sf::Vector2f world = window.mapPixelToCoords({event.mouseButton.x, event.mouseButton.y}, camera.getView());
+                    int x = int(floor(world.x / CELL_SIZE)); // деление на размер клетки (для корректной работы)
+                    int y = int(floor(world.y / CELL_SIZE));
                     
-                    if (maze.isValidCell(x, y)) { // если координаты валидны
+                    if (generating) {
+                        cout << "Лабиринт еще генерируется\n";
+                    }
+                    else if (maze.isValidCell(x, y)) { // если координаты валидны
+                        overlayDirty = true; // выбор точек меняется
                         if (startPointSelected && endPointSelected) { // если выбраны обе точки
-                            // Третий клик - сброс точек
-                            startPointSelected = false;
-                            endPointSelected = false;
-                            pathFound = false;
-                            cout << "Точки сброшены\n\n";
+                            // следующий клик переносит конечную точку, идущий поиск начинается заново
+                            endX = x;
+                            endY = y;
+                            cout << "Конечная точка: (" << x << ", " << y << ")\n";
+                            startSearch();
                         }
                         else if (!startPointSelected) { // если не выбрана начальная точка
                             startX = x;
@@ -100,68 +294,192 @@ int main() {
                             endPointSelected = true;
                             cout << "Конечная точка: (" << x << ", " << y << ")\n";
                             
-                            // Ищем путь
-                            path = pathFinder.findPath(maze, startX, startY, endX, endY);
-                            pathFound = !path.empty(); // если путь не пустой
-                            if (pathFound) {
-                                cout << "Путь найден!\n\n";
-                            } else {
-                                cout << "Путь не найден!\n\n";
-                            }
+                            // Ищем путь (по шагам в следующих кадрах)
+                            startSearch();
                         }
                     }
                 }
                 else if (event.mouseButton.button == sf::Mouse::Right) { // ПКМ
-                    // генерируем новый лабиринт
-                    maze = Maze(width, height);
-                    generator.generate(maze);
+                    // генерируем новый лабиринт в фоне в тот же буфер (текущая генерация отменяется)
+                    cancelSearch();
+                    background.start(maze, generator);
+                    generating = true;
                     pathFound = false;
                     startPointSelected = false;
                     endPointSelected = false;
-                    cout << "Новый лабиринт создан\n\n";
+                    overlayDirty = true;
+                    cout << "Генерация нового лабиринта\n";
+                    reportSeed(maze);
                 }
             }
             else if (event.type == sf::Event::KeyPressed) { // если нажата клавиша
                 if (event.key.code == sf::Keyboard::Space) { // пробел
                     // cброс выбранных точек
+                    cancelSearch();
                     startPointSelected = false;
                     endPointSelected = false;
                     pathFound = false;
+                    overlayDirty = true;
                     cout << "\nТочки сброшены\n\n";
                 }
+                else if (event.key.code >= sf::Keyboard::Num1 &&
+                         event.key.code < sf::Keyboard::Num1 + int(pathFinderNames().size())) { // выбор алгоритма
+                    finderIndex = size_t(event.key.code - sf::Keyboard::Num1);
+                    cancelSearch();
+                    pathFinder = makePathFinder(finderNames[finderIndex]);
+                    cout << "Алгоритм поиска пути: " << pathFinder->getName() << "\n";
+                    if (startPointSelected && endPointSelected && !generating) { // повторяем поиск для выбранных точек
+                        startSearch();
+                    } else {
+                        cout << "\n";
+                    }
+                }
+                else if (event.key.code == sf::Keyboard::F3) { // сводка замеров
+                    hudVisible = !hudVisible;
+                    if (!hudVisible) window.setTitle("LABIRINT");
+                    else if (!hud.hasFont()) cout << "Шрифт не найден: замеры выводятся в заголовок окна\n";
+                }
+                else if (event.key.code == sf::Keyboard::F12) { // выгрузка журнала замеров
+                    bool written = Profiler::instance().writeCsv("maze_trace.csv") && Profiler::instance().writeJson("maze_trace.json");
+                    cout << (written ? "Журнал замеров сохранен в maze_trace.csv и maze_trace.json\n\n"
+                                     : "Ошибка сохранения журнала замеров\n\n");
+                }
+                else if (event.key.code == sf::Keyboard::H) { // тепловая карта
+                    heatmapVisible = !heatmapVisible;
+                    cout << "Тепловая карта " << (heatmapVisible ? "включена" : "выключена") << "\n";
+                    if (heatmapVisible && !dynamic_cast<DistanceFieldPathFinder*>(pathFinder.get())) {
+                        cout << "Тепловая карта строится алгоритмом field (клавиша " << fieldIndex + 1 << ")\n";
+                    }
+                    cout << "\n";
+                }
+                else if (event.key.code == sf::Keyboard::Escape && searching) { // остановка поиска
+                    cancelSearch();
+                    cout << "Поиск остановлен\n\n";
+                }
+                else if (event.key.code == sf::Keyboard::Home) { // весь лабиринт в окне
+                    camera.fit(window.getSize());
+                    mazeLayerDirty = true;
+                }
+                else if (event.key.code == sf::Keyboard::Left || event.key.code == sf::Keyboard::Right ||
+                         event.key.code == sf::Keyboard::Up || event.key.code == sf::Keyboard::Down) {
+                    // перемещение вида стрелками на десятую часть окна
+                    sf::Vector2i center(windowSize.x / 2, windowSize.y / 2), target = center;
+                    int stepX = windowSize.x / 10, stepY = windowSize.y / 10;
+                    if (event.key.code == sf::Keyboard::Left) target.x += stepX;
+                    if (event.key.code == sf::Keyboard::Right) target.x -= stepX;
+                    if (event.key.code == sf::Keyboard::Up) target.y += stepY;
+                    if (event.key.code == sf::Keyboard::Down) target.y -= stepY;
+                    camera.pan(window, center, target);
+                    mazeLayerDirty = true;
+                }
+                else if (event.key.code == sf::Keyboard::S) { // S
+                    // сохраняем лабиринт в бинарный файл
+                    if (generating) {
+                        cout << "Лабиринт еще генерируется\n";
+                        continue;
+                    }
+                    try {
+                        maze.save("maze.bin");
+                        cout << "Лабиринт сохранен в maze.bin\n\n";
+                    } catch (const exception& e) {
+                        cout << "Ошибка сохранения: " << e.what() << "\n\n";
+                    }
+                }
             }
         }
 
-        // очищаем окно
-        window.clear(sf::Color::Black);
+        // продвигаем поиск пути в пределах бюджета кадра
+        if (searching) {
+            redraw = true;
+            auto deadline = chrono::steady_clock::now() + SEARCH_BUDGET;
+            SearchStatus status;
+            do {
+                status = pathFinder->step(SEARCH_STEP_CELLS);
+            } while (status == SearchStatus::Running && chrono::steady_clock::now() < deadline);
+
+            frontierCells.clear();
+            if (status == SearchStatus::Running) pathFinder->appendFrontier(frontierCells);
+            searchView.update(expandedCells, frontierCells, width, height, CELL_SIZE);
+            expandedCells.clear();
+            if (status != SearchStatus::Running) { // поиск закончен
+                searching = false;
+                pathFound = status == SearchStatus::Found;
+                path = pathFinder->getPath();
+                overlayDirty = true;
+                reportPath(*pathFinder, path);
+            }
+        }
+
+        // тепловая карта: поле от начальной точки достраивается в пределах бюджета кадра
+        fieldFinder = dynamic_cast<DistanceFieldPathFinder*>(pathFinder.get()); // алгоритм мог смениться
+        bool heatmapShown = false; // карта соответствует текущей начальной точке и лабиринту
+        if (heatmapVisible && fieldFinder && startPointSelected && !generating && !searching) {
+            DistanceField& field = fieldFinder->getField();
+            if (!field.isValidFor(maze, startX, startY)) field.reset(maze, startX, startY);
+            auto deadline = chrono::steady_clock::now() + SEARCH_BUDGET;
+            while (!field.isComplete() && chrono::steady_clock::now() < deadline) field.extend(SEARCH_STEP_CELLS);
+            if (heatmap.update(field, CELL_SIZE)) mazeLayerDirty = true;
+            heatmapShown = heatmap.isReadyFor(maze.getRevision(), startY * width + startX);
+        }
 
-        // отрисовываем лабиринт
-        maze.draw(window, CELL_SIZE);
+        // слой лабиринта устарел: изменились лабиринт, число готовых строк или наличие карты
+        int readyRows = generating ? background.getReadyRows() : INT_MAX;
+        if (maze.getRevision() != layerRevision || readyRows != layerRows || heatmapShown != layerHeatmap ||
+            mazeRenderer.hasPendingWork()) {
+            mazeLayerDirty = true;
+        }
+        if (mazeLayerDirty) redraw = true;
+        if (!redraw) { // ничего не изменилось - кадр не перерисовываем
+            if (generating) sf::sleep(GENERATION_POLL); // новых строк нет: не крутим pollEvent впустую
+            continue;
+        }
 
-        // Отрисовываем выбранные точки и путь
-        if (startPointSelected) {
-            // создаем синюю точкуу
-            sf::CircleShape startPoint(CELL_SIZE / 4); // круг
-            startPoint.setPosition(startX * CELL_SIZE + CELL_SIZE/4, startY * CELL_SIZE + CELL_SIZE/4); // позицию
-            startPoint.setFillColor(sf::Color::Blue); // цвет
-            window.draw(startPoint); // отрисовываем
+        // перерисовываем слой лабиринта, только если он устарел
+        if (mazeLayerDirty) {
+            mazeLayer.clear(sf::Color::Black);
+            mazeLayer.setView(camera.getView()); // лабиринт рисуется в координатах мира
+            if (heatmapShown) heatmap.draw(mazeLayer); // расстояния от начальной точки (под стенами)
+            // отрисовываем лабиринт (один вызов draw), во время генерации - только готовые строки
+            mazeRenderer.draw(mazeLayer, maze, CELL_SIZE, readyRows);
+            mazeLayer.display();
+            layerRevision = maze.getRevision();
+            layerRows = readyRows;
+            layerHeatmap = heatmapShown;
+            mazeLayerDirty = false;
         }
-        
-        if (endPointSelected) {
-            // создаем красную точку
-            sf::CircleShape endPoint(CELL_SIZE / 4);
-            endPoint.setPosition(endX * CELL_SIZE + CELL_SIZE/4, endY * CELL_SIZE + CELL_SIZE/4);
-            endPoint.setFillColor(sf::Color::Red);
-            window.draw(endPoint);
+
+        // кадр: готовый слой лабиринта одной копией, наложения поверх
+        window.clear(sf::Color::Black);
+        window.setView(sf::View(sf::FloatRect(0, 0, float(windowSize.x), float(windowSize.y))));
+        window.draw(sf::Sprite(mazeLayer.getTexture()));
+        Profiler::instance().count("draw calls");
+        window.setView(camera.getView()); // наложения рисуются в координатах мира
+
+        searchView.draw(window); // ход поиска (под путем и точками)
+
+        // пересобираем наложение только при изменении точек или пути
+        if (overlayDirty) {
+            overlay.clear();
+            if (pathFound) overlay.addPath(path, CELL_SIZE, sf::Color::Green); // путь
+            if (startPointSelected) overlay.addMarker(startX, startY, CELL_SIZE, sf::Color::Blue); // начальная точка
+            if (endPointSelected) overlay.addMarker(endX, endY, CELL_SIZE, sf::Color::Red); // конечная точка
+            overlayDirty = false;
         }
+        overlay.draw(window); // выбранные точки и путь (один вызов draw)
 
-        // если путь найден, отрисовываем его
-        if (pathFound) {
-            pathFinder.drawPath(window, CELL_SIZE, path);
+        if (hudVisible) { // сводка замеров на экране или (без шрифта) в заголовке дважды в секунду
+            if (hud.hasFont()) hud.draw(window);
+            else if (frameStart - titleUpdate > chrono::milliseconds(500)) {
+                window.setTitle("LABIRINT | " + ProfilerHud::summary(" | "));
+                titleUpdate = frameStart;
+            }
         }
 
         // отображаем все нарисованное в окне
         window.display();
+        redraw = false;
+        Profiler::instance().record("frame", frameStart, chrono::steady_clock::now());
+        Profiler::instance().endFrame();
     }
 
     return 0;